@@ -0,0 +1,108 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include <random>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "dust.hpp"
+#include "lmdb_bucket.hpp"
+#include "memdb_bucket.hpp"
+
+using namespace silkworm;
+
+namespace {
+
+// a fresh bucket each time, as LMDB ones outlive their objects
+template <class Bucket>
+Bucket new_bucket() {
+  static int counter = 0;
+  return Bucket("bench" + std::to_string(counter++));
+}
+
+template <class Bucket>
+void fill(Bucket& db, const std::vector<sync::Leaf>& leaves) {
+  auto it = leaves.begin();
+  db.put([&it, &leaves]() -> std::optional<DbBucket::KeyVal> {
+    if (it == leaves.end()) {
+      return {};
+    }
+    const auto& leaf = *it++;
+    return DbBucket::KeyVal{byte_view(leaf.first), leaf.second};
+  });
+}
+
+}  // namespace
+
+template <class Bucket>
+static void BM_Put(benchmark::State& state) {
+  const auto& leaves = bench::dust_leaves(state.range(0));
+  for (auto _ : state) {
+    auto db = new_bucket<Bucket>();
+    fill(db, leaves);
+
+    state.PauseTiming();
+    db.del("", {});
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * leaves.size());
+}
+BENCHMARK_TEMPLATE(BM_Put, MemDbBucket)
+    ->Apply(bench::state_sizes)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Put, LmdbBucket)
+    ->Apply(bench::state_sizes)
+    ->Unit(benchmark::kMillisecond);
+
+template <class Bucket>
+static void BM_Get(benchmark::State& state) {
+  const auto& leaves = bench::dust_leaves(state.range(0));
+  auto db = new_bucket<Bucket>();
+  fill(db, leaves);
+
+  std::mt19937_64 rng(state.range(0));
+  std::uniform_int_distribution<size_t> dist(0, leaves.size() - 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(db.get(byte_view(leaves[dist(rng)].first)));
+  }
+  db.del("", {});
+}
+BENCHMARK_TEMPLATE(BM_Get, MemDbBucket)->Apply(bench::state_sizes);
+BENCHMARK_TEMPLATE(BM_Get, LmdbBucket)->Apply(bench::state_sizes);
+
+template <class Bucket>
+static void BM_Scan(benchmark::State& state) {
+  const auto& leaves = bench::dust_leaves(state.range(0));
+  auto db = new_bucket<Bucket>();
+  fill(db, leaves);
+
+  for (auto _ : state) {
+    size_t bytes = 0;
+    db.get("", {}, [&bytes](std::string_view key, std::string_view val) {
+      bytes += key.size() + val.size();
+    });
+    benchmark::DoNotOptimize(bytes);
+  }
+  state.SetItemsProcessed(state.iterations() * leaves.size());
+  db.del("", {});
+}
+BENCHMARK_TEMPLATE(BM_Scan, MemDbBucket)
+    ->Apply(bench::state_sizes)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Scan, LmdbBucket)
+    ->Apply(bench::state_sizes)
+    ->Unit(benchmark::kMillisecond);
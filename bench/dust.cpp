@@ -0,0 +1,71 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "dust.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <memory>
+
+#include "dust_generator.hpp"
+#include "keccak.hpp"
+
+namespace silkworm::bench {
+
+const std::vector<sync::Leaf>& dust_leaves(size_t num_leaves) {
+  static std::map<size_t, std::vector<sync::Leaf>> cache;
+  auto& leaves = cache[num_leaves];
+  if (leaves.size() == num_leaves) {
+    return leaves;
+  }
+
+  lab::RNG rng(3548264823u);
+  lab::DustGenerator dust_gen(rng);
+  leaves.reserve(num_leaves);
+  for (size_t i = 0; i < num_leaves; ++i) {
+    leaves.emplace_back(keccak(byte_view(dust_gen.random_address())),
+                        to_rlp(dust_gen.random_account()));
+  }
+  std::sort(leaves.begin(), leaves.end());
+  return leaves;
+}
+
+MemDbBucket& dust_state(size_t num_leaves) {
+  static std::map<size_t, std::unique_ptr<MemDbBucket>> cache;
+  auto& db = cache[num_leaves];
+  if (!db) {
+    db = std::make_unique<MemDbBucket>();
+    for (const auto& leaf : dust_leaves(num_leaves)) {
+      db->put(byte_view(leaf.first), leaf.second);
+    }
+  }
+  return *db;
+}
+
+void state_sizes(benchmark::internal::Benchmark* b) {
+  size_t max_leaves = 1'000'000;
+  if (const char* env = std::getenv("SILKWORM_BENCH_MAX_LEAVES")) {
+    max_leaves = std::strtoull(env, nullptr, 10);
+  }
+  for (const size_t n : {1'000'000, 10'000'000, 50'000'000}) {
+    if (n <= max_leaves) {
+      b->Arg(n);
+    }
+  }
+}
+
+}  // namespace silkworm::bench
@@ -0,0 +1,43 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_BENCH_DUST_HPP_
+#define SILKWORM_BENCH_DUST_HPP_
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "memdb_bucket.hpp"
+#include "sync.hpp"
+
+// Random dust accounts shared by the benchmarks, generated once per size.
+
+namespace silkworm::bench {
+
+// strictly ordered by key, the keccak of the address
+const std::vector<sync::Leaf>& dust_leaves(size_t num_leaves);
+
+// the same leaves in a bucket, which must not be modified
+MemDbBucket& dust_state(size_t num_leaves);
+
+// Adds the state sizes to benchmark with: 1M leaves and up to
+// SILKWORM_BENCH_MAX_LEAVES, 10M and 50M if it's set high enough.
+void state_sizes(benchmark::internal::Benchmark*);
+
+}  // namespace silkworm::bench
+
+#endif  // SILKWORM_BENCH_DUST_HPP_
@@ -0,0 +1,46 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "keccak.hpp"
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace silkworm;
+
+static void BM_Keccak(benchmark::State& state) {
+  const std::string in(state.range(0), 'x');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(keccak(in));
+  }
+  state.SetBytesProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_Keccak)->Arg(32)->Arg(80)->Arg(532)->Arg(4096);
+
+// dust leaf values hashed together, as by sync::hash_leaves
+static void BM_KeccakBatch(benchmark::State& state) {
+  const std::vector<std::string> values(state.range(0), std::string(80, 'x'));
+  const std::vector<std::string_view> in(values.begin(), values.end());
+  std::vector<Hash> out(in.size());
+  for (auto _ : state) {
+    keccak(in.data(), out.data(), in.size());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_KeccakBatch)->Arg(4)->Arg(256);
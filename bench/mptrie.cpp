@@ -0,0 +1,51 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "mptrie.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include "dust.hpp"
+
+using namespace silkworm;
+
+// with the given number of non-empty children
+static void BM_BranchNodeHash(benchmark::State& state) {
+  std::bitset<16> empty;
+  std::array<Hash, 16> hash{};
+  for (Nibble i = 0; i < 16; ++i) {
+    empty[i] = i >= state.range(0);
+    hash[i][0] = i;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mptrie::branch_node_hash(empty, hash));
+  }
+}
+BENCHMARK(BM_BranchNodeHash)->Arg(1)->Arg(4)->Arg(16);
+
+// leaves per bottom node
+static void BM_LeafHasher(benchmark::State& state) {
+  const auto& leaves = bench::dust_leaves(state.range(0));
+  for (auto _ : state) {
+    LeafHasher hasher;
+    for (const auto& leaf : leaves) {
+      hasher.append(byte_view(leaf.first), leaf.second);
+    }
+    benchmark::DoNotOptimize(hasher.hash());
+  }
+  state.SetItemsProcessed(state.iterations() * leaves.size());
+}
+BENCHMARK(BM_LeafHasher)->Arg(16)->Arg(256);
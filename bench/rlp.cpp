@@ -0,0 +1,80 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "rlp.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include "account.hpp"
+
+using namespace silkworm;
+
+namespace {
+
+Account sample_account() {
+  Account account;
+  account.nonce = 1023;
+  account.balance = 17 * kEther;
+  account.storage[7] = 0x5e;
+  return account;
+}
+
+// a branch node with a nested list, in the generic representation
+rlp::Item sample_item() {
+  rlp::List node;
+  for (int i = 0; i < 16; ++i) {
+    node.push_back(i % 3 ? std::string(kHashBytes, 'h') : std::string{});
+  }
+  node.push_back(
+      rlp::List{std::string("crypto kitties"), std::string(60, 'v')});
+  return node;
+}
+
+}  // namespace
+
+static void BM_AccountToRlp(benchmark::State& state) {
+  const auto account = sample_account();
+  char buf[kMaxAccountRlpSize];
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(to_rlp(account, buf));
+  }
+}
+BENCHMARK(BM_AccountToRlp);
+
+static void BM_AccountFromRlp(benchmark::State& state) {
+  const auto in = to_rlp(sample_account());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(account_from_rlp(in));
+  }
+}
+BENCHMARK(BM_AccountFromRlp);
+
+static void BM_RlpEncode(benchmark::State& state) {
+  const auto item = sample_item();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(rlp::encode(item));
+  }
+}
+BENCHMARK(BM_RlpEncode);
+
+static void BM_RlpDecode(benchmark::State& state) {
+  const auto in = rlp::encode(sample_item());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(rlp::decode(in));
+  }
+  state.SetBytesProcessed(state.iterations() * in.size());
+}
+BENCHMARK(BM_RlpDecode);
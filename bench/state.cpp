@@ -0,0 +1,42 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "state.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include "dust.hpp"
+
+using namespace silkworm;
+
+// at the depth the sync would use for this many leaves
+static void BM_InitFromDb(benchmark::State& state) {
+  sync::Hints hints;
+  hints.num_leaves = state.range(0);
+  const auto depth = hints.optimal_phase2_depth();
+
+  auto& db = bench::dust_state(state.range(0));
+  for (auto _ : state) {
+    State tree(db, depth, depth);
+    tree.init_from_db(7212230);
+    benchmark::DoNotOptimize(tree.root_hash());
+  }
+  state.SetItemsProcessed(state.iterations() * hints.num_leaves);
+  state.counters["depth"] = depth;
+}
+BENCHMARK(BM_InitFromDb)
+    ->Apply(bench::state_sizes)
+    ->Unit(benchmark::kSecond);
@@ -16,17 +16,20 @@
 
 #include "account.hpp"
 
-#include "rlp.hpp"
-
 namespace silkworm {
 
 std::string to_rlp(const Account& in) {
-  thread_local rlp::List list = {"", "", "", ""};
-  boost::get<std::string>(list[0]) = rlp::to_big_endian(in.nonce);
-  boost::get<std::string>(list[1]) = rlp::to_big_endian(in.balance);
-  boost::get<std::string>(list[2]) = byte_view(in.storage);
-  boost::get<std::string>(list[3]) = byte_view(in.code);
+  char buf[kMaxAccountRlpSize];
+  return std::string(buf, to_rlp(in, buf) - buf);
+}
+
+char* to_rlp(const Account& in, char* out) {
+  return rlp::Codec<Account>::encode(in, out);
+}
 
-  return rlp::encode(list);
+Account account_from_rlp(std::string_view in) {
+  Account out;
+  rlp::Codec<Account>::decode(in, out);
+  return out;
 }
 }  // namespace silkworm
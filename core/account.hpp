@@ -18,6 +18,7 @@
 #define SILKWORM_CORE_ACCOUNT_HPP_
 
 #include "keccak.hpp"
+#include "rlp_schema.hpp"
 
 namespace silkworm {
 
@@ -31,6 +32,24 @@ struct Account {
 
 std::string to_rlp(const Account&);
 
+// a list of 4 strings of at most 8, 32, 32 & 32 bytes
+static constexpr size_t kMaxAccountRlpSize = 2 + 9 + 3 * 33;
+
+// Writes to_rlp into out, which must have room for kMaxAccountRlpSize
+// bytes. Returns the end of the output.
+char* to_rlp(const Account&, char* out);
+
+// throws std::invalid_argument if the input is not a valid account
+Account account_from_rlp(std::string_view);
+
 }  // namespace silkworm
 
+namespace silkworm::rlp {
+
+template <>
+struct Codec<Account> : Schema<Account, &Account::nonce, &Account::balance,
+                               &Account::storage, &Account::code> {};
+
+}  // namespace silkworm::rlp
+
 #endif  // SILKWORM_CORE_ACCOUNT_HPP_
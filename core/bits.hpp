@@ -0,0 +1,89 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_BITS_HPP_
+#define SILKWORM_CORE_BITS_HPP_
+
+#include <stdint.h>
+#ifdef _MSC_VER
+#include <stdlib.h>
+#endif
+
+// Bit twiddling that GCC & Clang have builtins for, with portable
+// fallbacks for MSVC.
+
+namespace silkworm {
+
+// 64 for zero
+constexpr unsigned count_leading_zeros(uint64_t x) {
+  if (!x) {
+    return 64;
+  }
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_clzll(x));
+#else
+  unsigned n = 0;
+  for (unsigned shift = 32; shift; shift /= 2) {
+    if (!(x >> (64 - shift))) {
+      n += shift;
+      x <<= shift;
+    }
+  }
+  return n;
+#endif
+}
+
+// 64 for zero
+constexpr unsigned count_trailing_zeros(uint64_t x) {
+  if (!x) {
+    return 64;
+  }
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+  unsigned n = 0;
+  for (unsigned shift = 32; shift; shift /= 2) {
+    if (!(x << (64 - shift))) {
+      n += shift;
+      x >>= shift;
+    }
+  }
+  return n;
+#endif
+}
+
+#if defined(__BYTE_ORDER__)
+constexpr bool kLittleEndian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+#else
+// MSVC, which targets little-endian platforms only
+constexpr bool kLittleEndian = true;
+#endif
+
+inline uint64_t byte_swap(uint64_t x) {
+#if defined(_MSC_VER)
+  return _byteswap_uint64(x);
+#elif defined(__GNUC__)
+  return __builtin_bswap64(x);
+#else
+  x = (x & 0x00ff'00ff'00ff'00ff) << 8 | (x >> 8 & 0x00ff'00ff'00ff'00ff);
+  x = (x & 0x0000'ffff'0000'ffff) << 16 | (x >> 16 & 0x0000'ffff'0000'ffff);
+  return x << 32 | x >> 32;
+#endif
+}
+
+}  // namespace silkworm
+
+#endif  // SILKWORM_CORE_BITS_HPP_
@@ -21,12 +21,10 @@
 #include <string>
 #include <string_view>
 
-#include <boost/multiprecision/cpp_int.hpp>
+#include "uint256.hpp"
 
 namespace silkworm {
 
-using UInt256 = boost::multiprecision::uint256_t;
-
 std::string bytes_to_hex_string(std::string_view);
 std::string hex_string_to_bytes(std::string_view);
 
@@ -18,6 +18,7 @@
 #define SILKWORM_CORE_DB_BUCKET_HPP_
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string_view>
 #include <utility>
@@ -49,6 +50,11 @@ class DbBucket {
   virtual void del(std::string_view lower,
                    std::optional<std::string_view> upper) = 0;
 
+  // While the returned handle is alive, the entries seen by get stay valid
+  // as they were, even once changed or deleted, so that readers can keep
+  // views of them rather than copies. {} if the bucket can't do that.
+  virtual std::shared_ptr<const void> pin() const { return {}; }
+
  protected:
   DbBucket() = default;
 
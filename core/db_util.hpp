@@ -17,6 +17,10 @@
 #ifndef SILKWORM_CORE_DB_UTIL_HPP_
 #define SILKWORM_CORE_DB_UTIL_HPP_
 
+#include <functional>
+#include <string>
+#include <vector>
+
 #include "mptrie.hpp"
 #include "prefix.hpp"
 
@@ -44,6 +48,68 @@ void del(DbBucket& db, Prefix p) {
   db.del(range.first, range.second);
 }
 
+// Makes the entries under the prefix those of leaves, a sorted container
+// of (Hash, value) pairs, by merge-joining it against the current entries
+// and writing only the inserts, updates and deletes. Deletes with no
+// unchanged entry between them go out as one range; updated entries may
+// fall inside it since they are put afterwards. on_change, if given, is
+// called with the key of every entry inserted, updated or deleted.
+template <class DbBucket, class Leaves>
+void replace(
+    DbBucket& db, Prefix p, const Leaves& leaves,
+    const std::function<void(std::string_view)>& on_change = nullptr) {
+  std::vector<bool> changed(leaves.size(), true);
+  auto num_changed = leaves.size();
+  std::vector<std::pair<std::string, std::string>> deleted;
+  bool extend = false;
+
+  size_t i = 0;
+  iterate(db, p, [&](std::string_view key, std::string_view val) {
+    for (; i < leaves.size() && byte_view(leaves[i].first) < key; ++i) {
+    }
+    if (i < leaves.size() && byte_view(leaves[i].first) == key) {
+      if (leaves[i].second == val) {
+        changed[i] = false;
+        --num_changed;
+        extend = false;
+      }
+      ++i;
+    } else {
+      if (extend) {
+        deleted.back().second.assign(key).push_back('\0');
+      } else {
+        deleted.emplace_back(key, std::string(key) + '\0');
+        extend = true;
+      }
+      if (on_change) {
+        on_change(key);
+      }
+    }
+  });
+
+  for (const auto& range : deleted) {
+    db.del(range.first, range.second);
+  }
+
+  if (num_changed == 0) {
+    return;
+  }
+
+  i = 0;
+  db.put([&]() -> std::optional<typename DbBucket::KeyVal> {
+    for (; i < leaves.size() && !changed[i]; ++i) {
+    }
+    if (i == leaves.size()) {
+      return {};
+    }
+    const auto& leaf = leaves[i++];
+    if (on_change) {
+      on_change(byte_view(leaf.first));
+    }
+    return typename DbBucket::KeyVal(byte_view(leaf.first), leaf.second);
+  });
+}
+
 }  // namespace silkworm::db_util
 
 #endif  // SILKWORM_CORE_DB_UTIL_HPP_
@@ -0,0 +1,135 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "hierarchical_bitmap.hpp"
+
+#include "bits.hpp"
+
+namespace {
+
+// bits [begin, end) of a word, where end <= 64
+uint64_t mask(unsigned begin, unsigned end) {
+  const auto upper = end == 64 ? ~0ull : (1ull << end) - 1;
+  return upper & (~0ull << begin);
+}
+
+}  // namespace
+
+namespace silkworm {
+
+HierarchicalBitmap::HierarchicalBitmap(uint64_t size, bool value)
+    : size_{size} {
+  uint64_t num_bits = size;
+  do {
+    levels_.emplace_back((num_bits + 63) / 64);
+    num_bits = levels_.back().size();
+  } while (num_bits > 1);
+
+  if (value) {
+    set(0, size);
+  }
+}
+
+void HierarchicalBitmap::set(uint64_t i) {
+  for (auto& level : levels_) {
+    auto& word = level[i / 64];
+    const bool was_zero = word == 0;
+    word |= 1ull << (i % 64);
+    if (!was_zero) {
+      return;  // the summaries already have it
+    }
+    i /= 64;
+  }
+}
+
+void HierarchicalBitmap::reset(uint64_t i) {
+  for (auto& level : levels_) {
+    auto& word = level[i / 64];
+    word &= ~(1ull << (i % 64));
+    if (word != 0) {
+      return;
+    }
+    i /= 64;
+  }
+}
+
+void HierarchicalBitmap::set(uint64_t begin, uint64_t end) {
+  for (auto& level : levels_) {
+    if (begin >= end) {
+      return;
+    }
+    const auto first = begin / 64;
+    const auto last = (end - 1) / 64;
+    for (auto w = first; w <= last; ++w) {
+      const unsigned from = w == first ? begin % 64 : 0;
+      const unsigned to = w == last ? (end - 1) % 64 + 1 : 64;
+      level[w] |= mask(from, to);
+    }
+    begin = first;
+    end = last + 1;
+  }
+}
+
+void HierarchicalBitmap::reset(uint64_t begin, uint64_t end) {
+  for (auto& level : levels_) {
+    if (begin >= end) {
+      return;
+    }
+    const auto first = begin / 64;
+    const auto last = (end - 1) / 64;
+    for (auto w = first; w <= last; ++w) {
+      const unsigned from = w == first ? begin % 64 : 0;
+      const unsigned to = w == last ? (end - 1) % 64 + 1 : 64;
+      level[w] &= ~mask(from, to);
+    }
+    // only the words cleared entirely clear their summary bits
+    begin = level[first] ? first + 1 : first;
+    end = level[last] && last >= begin ? last : last + 1;
+  }
+}
+
+uint64_t HierarchicalBitmap::find_next(uint64_t i) const {
+  if (i >= size_) {
+    return size_;
+  }
+
+  // up to the first level with a set bit at or after the position
+  size_t lvl = 0;
+  while (true) {
+    const auto w = i / 64;
+    if (w < levels_[lvl].size()) {
+      const auto word = levels_[lvl][w] & (~0ull << (i % 64));
+      if (word) {
+        i = w * 64 + count_trailing_zeros(word);
+        break;
+      }
+    }
+    if (lvl + 1 == levels_.size()) {
+      return size_;
+    }
+    ++lvl;
+    i = w + 1;
+  }
+
+  // and down to the first set bit below it
+  while (lvl > 0) {
+    --lvl;
+    i = i * 64 + count_trailing_zeros(levels_[lvl][i]);
+  }
+  return i;
+}
+
+}  // namespace silkworm
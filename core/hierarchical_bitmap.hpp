@@ -0,0 +1,58 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_HIERARCHICAL_BITMAP_HPP_
+#define SILKWORM_CORE_HIERARCHICAL_BITMAP_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace silkworm {
+
+// Bitmap that finds the next set bit in a few word operations however
+// sparse it is: each level above the bits has a bit per word of the level
+// below, set iff the word is non-zero.
+class HierarchicalBitmap {
+ public:
+  explicit HierarchicalBitmap(uint64_t size = 0, bool value = false);
+
+  uint64_t size() const { return size_; }
+
+  bool test(uint64_t i) const {
+    return (levels_[0][i / 64] >> (i % 64)) & 1;
+  }
+
+  void set(uint64_t i);
+  void reset(uint64_t i);
+
+  // the bits in [begin, end)
+  void set(uint64_t begin, uint64_t end);
+  void reset(uint64_t begin, uint64_t end);
+
+  // the first set bit at or after i; size() if there is none
+  uint64_t find_next(uint64_t i) const;
+
+ private:
+  uint64_t size_;
+
+  // the bits first, then the summaries up to a single word
+  std::vector<std::vector<uint64_t>> levels_;
+};
+
+}  // namespace silkworm
+
+#endif  // SILKWORM_CORE_HIERARCHICAL_BITMAP_HPP_
@@ -149,3 +149,132 @@ static inline int hash(uint8_t* out, size_t outlen,
 /*** FIPS202 SHA3 FOFs ***/
 defsha3(256)
 defsha3(512)
+
+/******** 4-way interleaved Keccak-f[1600] ********/
+
+/* Four independent states, lane by lane, so that every step of the
+ * permutation works on the same lane of all states at once. */
+#if defined(__GNUC__)
+typedef uint64_t lanes4 __attribute__((vector_size(32)));
+#define LANE(v, k) ((v)[k])
+#define XOR(x, y) ((x) ^ (y))
+#define ANDN(x, y) ((~(x)) & (y))
+#define ROL(x, s) (((x) << (s)) | ((x) >> (64 - (s))))
+#else
+typedef struct { uint64_t k[4]; } lanes4;
+#define LANE(v, k) ((v).k[k])
+static inline lanes4 XOR(lanes4 x, lanes4 y) {
+  for (int i = 0; i < 4; ++i) x.k[i] ^= y.k[i];
+  return x;
+}
+static inline lanes4 ANDN(lanes4 x, lanes4 y) {
+  for (int i = 0; i < 4; ++i) x.k[i] = (~x.k[i]) & y.k[i];
+  return x;
+}
+static inline lanes4 ROL(lanes4 x, int s) {
+  for (int i = 0; i < 4; ++i) x.k[i] = rol(x.k[i], s);
+  return x;
+}
+#endif
+
+static inline void keccakf4(lanes4* a) {
+  lanes4 b[5];
+  lanes4 t;
+  uint8_t x, y;
+
+  for (int i = 0; i < 24; i++) {
+    // Theta
+    FOR5(x, 1,
+         b[x] = XOR(XOR(XOR(a[x], a[x + 5]), XOR(a[x + 10], a[x + 15])),
+                    a[x + 20]);)
+    FOR5(x, 1,
+         t = XOR(b[(x + 4) % 5], ROL(b[(x + 1) % 5], 1));
+         FOR5(y, 5,
+              a[y + x] = XOR(a[y + x], t); ))
+    // Rho and pi
+    t = a[1];
+    x = 0;
+    REPEAT24(b[0] = a[pi[x]];
+             a[pi[x]] = ROL(t, rho[x]);
+             t = b[0];
+             x++; )
+    // Chi
+    FOR5(y,
+       5,
+       FOR5(x, 1,
+            b[x] = a[y + x];)
+       FOR5(x, 1,
+            a[y + x] = XOR(b[x], ANDN(b[(x + 1) % 5], b[(x + 2) % 5])); ))
+    // Iota
+    for (int k = 0; k < 4; ++k) {
+      LANE(a[0], k) ^= RC[i];
+    }
+  }
+}
+
+/* Little-endian, as keccakf above. */
+static inline void xorin4(lanes4* a, int k, const uint8_t* src, size_t len) {
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t word;
+    memcpy(&word, src + i, 8);
+    LANE(a[i / 8], k) ^= word;
+  }
+  for (; i < len; ++i) {
+    LANE(a[i / 8], k) ^= (uint64_t)src[i] << (8 * (i % 8));
+  }
+}
+
+static inline void setout4(lanes4* a, int k, uint8_t* dst, size_t len) {
+  for (size_t i = 0; i < len; i += 8) {
+    const uint64_t word = LANE(a[i / 8], k);
+    memcpy(dst + i, &word, 8);
+  }
+}
+
+int sha3_256_x4(uint8_t* out[4], const uint8_t* const in[4],
+                const size_t inlen[4]) {
+  const size_t rate = 200 - 256 / 4;
+  lanes4 a[25];
+  memset(a, 0, sizeof(a));
+
+  const uint8_t* src[4];
+  size_t left[4];
+  int done[4];  // 1 once absorbed, 2 once squeezed
+  for (int k = 0; k < 4; ++k) {
+    if (out[k] == NULL || (in[k] == NULL && inlen[k] != 0)) {
+      return -1;
+    }
+    src[k] = in[k];
+    left[k] = inlen[k];
+    done[k] = 0;
+  }
+
+  // A shorter input is finished early; its state is then garbled by
+  // the permutations of the others, which doesn't matter.
+  while (done[0] < 2 || done[1] < 2 || done[2] < 2 || done[3] < 2) {
+    for (int k = 0; k < 4; ++k) {
+      if (done[k]) {
+        continue;
+      }
+      if (left[k] >= rate) {
+        xorin4(a, k, src[k], rate);
+        src[k] += rate;
+        left[k] -= rate;
+      } else {
+        xorin4(a, k, src[k], left[k]);
+        LANE(a[left[k] / 8], k) ^= (uint64_t)0x01 << (8 * (left[k] % 8));
+        LANE(a[(rate - 1) / 8], k) ^= (uint64_t)0x80 << (8 * ((rate - 1) % 8));
+        done[k] = 1;
+      }
+    }
+    keccakf4(a);
+    for (int k = 0; k < 4; ++k) {
+      if (done[k] == 1) {
+        setout4(a, k, out[k], 32);
+        done[k] = 2;
+      }
+    }
+  }
+  return 0;
+}
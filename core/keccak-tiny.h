@@ -27,6 +27,10 @@ extern "C" {
 int sha3_256(uint8_t* out, size_t outlen, const uint8_t* in, size_t inlen);
 int sha3_512(uint8_t* out, size_t outlen, const uint8_t* in, size_t inlen);
 
+// Four SHA3-256 hashes at once with an interleaved permutation.
+int sha3_256_x4(uint8_t* out[4], const uint8_t* const in[4],
+                const size_t inlen[4]);
+
 #ifdef __cplusplus
 }
 #endif
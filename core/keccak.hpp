@@ -37,6 +37,25 @@ inline Hash keccak(std::string_view in) {
   return out;
 }
 
+// out[i] = keccak(in[i]) for i < n, four at a time
+inline void keccak(const std::string_view* in, Hash* out, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    uint8_t* dst[4];
+    const uint8_t* src[4];
+    size_t len[4];
+    for (size_t k = 0; k < 4; ++k) {
+      dst[k] = out[i + k].data();
+      src[k] = reinterpret_cast<const uint8_t*>(in[i + k].data());
+      len[k] = in[i + k].size();
+    }
+    sha3_256_x4(dst, src, len);
+  }
+  for (; i < n; ++i) {
+    out[i] = keccak(in[i]);
+  }
+}
+
 inline std::array<uint8_t, 64> keccak512(std::string_view in) {
   std::array<uint8_t, 64> out;
   // https://stackoverflow.com/questions/10151834/why-cant-i-static-cast-between-char-and-unsigned-char
@@ -0,0 +1,97 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "leaf_batch.hpp"
+
+namespace silkworm::sync {
+
+LeafBatch::LeafBatch(const std::vector<Leaf>& leaves) {
+  size_t value_bytes = 0;
+  for (const auto& leaf : leaves) {
+    value_bytes += leaf.second.size();
+  }
+  reserve(leaves.size(), value_bytes);
+  for (const auto& leaf : leaves) {
+    push_back(leaf.first, leaf.second);
+  }
+}
+
+void LeafBatch::reserve(size_t num_leaves, size_t value_bytes) {
+  keys_.reserve(num_leaves);
+  if (pin_) {
+    views_.reserve(num_leaves);
+  } else {
+    ends_.reserve(num_leaves);
+    values_.reserve(value_bytes);
+  }
+}
+
+void LeafBatch::push_back(const Hash& key, std::string_view val) {
+  keys_.push_back(key);
+  if (pin_) {
+    views_.push_back(val);
+    view_bytes_ += val.size();
+  } else {
+    values_.append(val);
+    ends_.push_back(values_.size());
+  }
+}
+
+void LeafBatch::clear() {
+  keys_.clear();
+  ends_.clear();
+  values_.clear();
+  views_.clear();
+  view_bytes_ = 0;
+}
+
+bool LeafBatch::operator==(const LeafBatch& other) const {
+  if (keys_ != other.keys_) {
+    return false;
+  }
+  for (size_t i = 0; i < size(); ++i) {
+    if (value(i) != other.value(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LeafBatch::unpin() {
+  if (!pin_) {
+    return;
+  }
+  ends_.reserve(size());
+  values_.reserve(view_bytes_);
+  for (const auto& view : views_) {
+    values_.append(view);
+    ends_.push_back(values_.size());
+  }
+  views_ = {};
+  view_bytes_ = 0;
+  pin_.reset();
+}
+
+std::vector<Leaf> LeafBatch::to_vector() const {
+  std::vector<Leaf> leaves;
+  leaves.reserve(size());
+  for (const auto& leaf : *this) {
+    leaves.emplace_back(leaf.first, leaf.second);
+  }
+  return leaves;
+}
+
+}  // namespace silkworm::sync
@@ -0,0 +1,115 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_LEAF_BATCH_HPP_
+#define SILKWORM_CORE_LEAF_BATCH_HPP_
+
+#include <stddef.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+
+namespace silkworm::sync {
+
+using Leaf = std::pair<Hash, std::string>;
+
+// Leaves in three allocations however many there are: the keys, the ends
+// of the values, and the values back to back; or, if pinned, the keys and
+// views of values that the pin keeps valid. Must be strictly ordered by
+// key where leaves are expected to be.
+class LeafBatch {
+ public:
+  // valid until the batch is changed
+  using Ref = std::pair<const Hash&, std::string_view>;
+
+  class Iterator {
+   public:
+    Iterator(const LeafBatch* batch, size_t i) : batch_{batch}, i_{i} {}
+
+    Ref operator*() const { return (*batch_)[i_]; }
+
+    Iterator& operator++() {
+      ++i_;
+      return *this;
+    }
+
+    bool operator!=(const Iterator& other) const { return i_ != other.i_; }
+
+   private:
+    const LeafBatch* batch_;
+    size_t i_;
+  };
+
+  LeafBatch() = default;
+  explicit LeafBatch(const std::vector<Leaf>&);
+
+  // Keeps views of the values pushed rather than copies if pin is set,
+  // e.g. by DbBucket::pin.
+  explicit LeafBatch(std::shared_ptr<const void> pin) : pin_{std::move(pin)} {}
+
+  size_t size() const { return keys_.size(); }
+  bool empty() const { return keys_.empty(); }
+
+  // of all the values
+  size_t value_bytes() const { return pin_ ? view_bytes_ : values_.size(); }
+
+  Ref operator[](size_t i) const { return {keys_[i], value(i)}; }
+  Ref front() const { return (*this)[0]; }
+  Ref back() const { return (*this)[size() - 1]; }
+
+  Iterator begin() const { return {this, 0}; }
+  Iterator end() const { return {this, size()}; }
+
+  void reserve(size_t num_leaves, size_t value_bytes);
+
+  void push_back(const Hash& key, std::string_view val);
+
+  // keeps the memory for the next leaves
+  void clear();
+
+  // Copies the values in and releases the pin, e.g. before keeping the
+  // batch for long.
+  void unpin();
+
+  std::vector<Leaf> to_vector() const;
+
+  bool operator==(const LeafBatch&) const;
+
+ private:
+  std::string_view value(size_t i) const {
+    if (pin_) {
+      return views_[i];
+    }
+    const auto begin = i ? ends_[i - 1] : 0;
+    return std::string_view(values_).substr(begin, ends_[i] - begin);
+  }
+
+  std::vector<Hash> keys_;
+  std::vector<size_t> ends_;  // of each value in values_
+  std::string values_;
+
+  std::shared_ptr<const void> pin_;
+  std::vector<std::string_view> views_;
+  size_t view_bytes_ = 0;
+};
+
+}  // namespace silkworm::sync
+
+#endif  // SILKWORM_CORE_LEAF_BATCH_HPP_
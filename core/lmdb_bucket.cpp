@@ -45,7 +45,8 @@ LmdbEnvironment::LmdbEnvironment() : env_{lmdb::env::create()} {
 
   const auto tmp_dir = unique_path();
   create_directories(tmp_dir);
-  env_.open(tmp_dir.string().c_str(), MDB_NOSYNC, 0664);
+  // MDB_NOTLS for pins to overlap with other reads in a thread
+  env_.open(tmp_dir.string().c_str(), MDB_NOSYNC | MDB_NOTLS, 0664);
 }
 
 LmdbBucket::LmdbBucket(const std::string_view name, LmdbEnvironment& env)
@@ -132,6 +133,11 @@ void LmdbBucket::del(std::string_view lower,
   wtxn.commit();
 }
 
+std::shared_ptr<const void> LmdbBucket::pin() const {
+  return std::make_shared<lmdb::txn>(
+      lmdb::txn::begin(env_, nullptr, MDB_RDONLY));
+}
+
 bool LmdbBucket::has_same_data(const LmdbBucket& other) const {
   if (env_ != other.env_) {
     throw std::invalid_argument("buckets must belong to the same environment");
@@ -165,4 +171,27 @@ bool LmdbBucket::has_same_data(const LmdbBucket& other) const {
   }
 }
 
+LmdbStats LmdbBucket::stats() const {
+  LmdbStats out;
+
+  auto rtxn = lmdb::txn::begin(env_, nullptr, MDB_RDONLY);
+  const auto stat = dbi_.stat(rtxn);
+  rtxn.abort();
+
+  out.page_size = stat.ms_psize;
+  out.entries = stat.ms_entries;
+  out.depth = stat.ms_depth;
+  out.branch_pages = stat.ms_branch_pages;
+  out.leaf_pages = stat.ms_leaf_pages;
+  out.overflow_pages = stat.ms_overflow_pages;
+
+  MDB_envinfo info;
+  lmdb::env_info(env_, &info);
+  out.env_map_size = info.me_mapsize;
+  out.env_used_bytes = (info.me_last_pgno + 1) * out.page_size;
+  out.env_last_txn_id = info.me_last_txnid;
+
+  return out;
+}
+
 }  // namespace silkworm
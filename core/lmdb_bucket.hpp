@@ -41,6 +41,20 @@ class LmdbEnvironment {
   friend class LmdbBucket;
 };
 
+// Page usage of a bucket and of the environment it is in
+struct LmdbStats {
+  uint64_t page_size = 0;
+  uint64_t entries = 0;
+  uint64_t depth = 0;  // of the B+ tree
+  uint64_t branch_pages = 0;
+  uint64_t leaf_pages = 0;
+  uint64_t overflow_pages = 0;
+
+  uint64_t env_map_size = 0;    // in bytes
+  uint64_t env_used_bytes = 0;  // up to the last page used
+  uint64_t env_last_txn_id = 0;
+};
+
 class LmdbBucket : public DbBucket {
  public:
   explicit LmdbBucket(
@@ -65,8 +79,13 @@ class LmdbBucket : public DbBucket {
   void del(std::string_view lower,
            std::optional<std::string_view> upper) override;
 
+  // a read transaction, which keeps LMDB from reusing pages freed since
+  std::shared_ptr<const void> pin() const override;
+
   bool has_same_data(const LmdbBucket& other) const;
 
+  LmdbStats stats() const;
+
  private:
   lmdb::env& env_;
   lmdb::dbi dbi_;
@@ -21,8 +21,10 @@
 namespace silkworm {
 
 void MemDbBucket::put(const std::function<std::optional<KeyVal>()>& gen) {
+  auto hint = data_.end();
   while (const auto entry = gen()) {
-    put(entry->first, entry->second);
+    hint = std::next(
+        data_.insert_or_assign(hint, std::string(entry->first), entry->second));
   }
 }
 
@@ -34,6 +34,7 @@ class MemDbBucket : public DbBucket {
     data_[std::string(key)] = val;
   }
 
+  // amortized constant time per entry if the keys are ascending
   void put(const std::function<std::optional<KeyVal>()>& gen) override;
 
   std::optional<std::string_view> get(std::string_view key) const override;
@@ -0,0 +1,124 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "metered_db_bucket.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "bits.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+unsigned log2_bucket(uint64_t x) {
+  return x + 1 ? 63 - silkworm::count_leading_zeros(x + 1) : 63;
+}
+
+}  // namespace
+
+namespace silkworm {
+
+void MeteredDbBucket::put(std::string_view key, std::string_view val) {
+  const auto start = Clock::now();
+  db_.put(key, val);
+  metrics_.commit_latency.add(Clock::now() - start);
+
+  ++metrics_.num_puts;
+  ++metrics_.num_commits;
+  metrics_.bytes_written += key.size() + val.size();
+}
+
+void MeteredDbBucket::put(const std::function<std::optional<KeyVal>()>& gen) {
+  uint64_t entries = 0;
+  uint64_t bytes = 0;
+
+  const auto start = Clock::now();
+  db_.put([&gen, &entries, &bytes]() {
+    auto entry = gen();
+    if (entry) {
+      ++entries;
+      bytes += entry->first.size() + entry->second.size();
+    }
+    return entry;
+  });
+  metrics_.commit_latency.add(Clock::now() - start);
+
+  ++metrics_.num_batch_puts;
+  ++metrics_.num_commits;
+  metrics_.num_batch_entries += entries;
+  metrics_.bytes_written += bytes;
+}
+
+std::optional<std::string_view> MeteredDbBucket::get(
+    std::string_view key) const {
+  const auto start = Clock::now();
+  const auto val = db_.get(key);
+  metrics_.get_latency.add(Clock::now() - start);
+
+  ++metrics_.num_gets;
+  if (val) {
+    metrics_.bytes_read += key.size() + val->size();
+  } else {
+    ++metrics_.num_misses;
+  }
+  return val;
+}
+
+void MeteredDbBucket::get(
+    std::string_view lower, std::optional<std::string_view> upper,
+    const std::function<void(std::string_view, std::string_view)>& f) const {
+  uint64_t entries = 0;
+  uint64_t bytes = 0;
+
+  // includes the time spent in f
+  const auto start = Clock::now();
+  db_.get(lower, upper,
+          [&f, &entries, &bytes](std::string_view key, std::string_view val) {
+            ++entries;
+            bytes += key.size() + val.size();
+            f(key, val);
+          });
+  metrics_.scan_latency.add(Clock::now() - start);
+
+  ++metrics_.num_scans;
+  metrics_.num_scanned_entries += entries;
+  metrics_.bytes_read += bytes;
+  ++metrics_.scan_lengths[std::min<unsigned>(
+      log2_bucket(entries), metrics_.scan_lengths.size() - 1)];
+  metrics_.max_scan_length = std::max(metrics_.max_scan_length, entries);
+}
+
+void MeteredDbBucket::del(std::string_view lower,
+                          std::optional<std::string_view> upper) {
+  const auto start = Clock::now();
+  db_.del(lower, upper);
+  metrics_.commit_latency.add(Clock::now() - start);
+
+  ++metrics_.num_dels;
+  ++metrics_.num_commits;
+}
+
+DbMetrics MeteredDbBucket::metrics() const {
+  auto out = metrics_;
+  if (const auto lmdb = dynamic_cast<const LmdbBucket*>(&db_)) {
+    out.lmdb = lmdb->stats();
+  }
+  return out;
+}
+
+}  // namespace silkworm
@@ -0,0 +1,96 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_METERED_DB_BUCKET_HPP_
+#define SILKWORM_CORE_METERED_DB_BUCKET_HPP_
+
+#include <array>
+#include <optional>
+
+#include "db_bucket.hpp"
+#include "lmdb_bucket.hpp"
+#include "profiler.hpp"
+
+namespace silkworm {
+
+// A snapshot of MeteredDbBucket's counters
+struct DbMetrics {
+  using Histogram = sync::Profiler::Histogram;
+
+  uint64_t num_puts = 0;  // single entries
+  uint64_t num_batch_puts = 0;
+  uint64_t num_batch_entries = 0;
+  uint64_t num_gets = 0;
+  uint64_t num_misses = 0;
+  uint64_t num_scans = 0;
+  uint64_t num_scanned_entries = 0;
+  uint64_t num_dels = 0;  // ranges
+
+  // keys & values
+  uint64_t bytes_written = 0;
+  uint64_t bytes_read = 0;
+
+  // of scans returning [2^i - 1, 2^(i + 1) - 1) entries
+  std::array<uint64_t, 32> scan_lengths{};
+  uint64_t max_scan_length = 0;
+
+  // Puts & dels are one transaction each in LmdbBucket.
+  uint64_t num_commits = 0;
+  Histogram commit_latency;
+  Histogram get_latency;
+  Histogram scan_latency;
+
+  // if the bucket is an LmdbBucket
+  std::optional<LmdbStats> lmdb;
+};
+
+// Counts the operations on another bucket and times them.
+class MeteredDbBucket : public DbBucket {
+ public:
+  explicit MeteredDbBucket(DbBucket& db) : db_(db) {}
+
+  virtual ~MeteredDbBucket() = default;
+
+  void put(std::string_view key, std::string_view val) override;
+
+  void put(const std::function<std::optional<KeyVal>()>& gen) override;
+
+  std::optional<std::string_view> get(std::string_view key) const override;
+
+  // Iterate over entries with lower <= key < upper
+  // and call f(key, val) for each entry.
+  void get(std::string_view lower, std::optional<std::string_view> upper,
+           const std::function<void(std::string_view, std::string_view)>& f)
+      const override;
+
+  // Delete all entries with lower <= key < upper.
+  void del(std::string_view lower,
+           std::optional<std::string_view> upper) override;
+
+  std::shared_ptr<const void> pin() const override { return db_.pin(); }
+
+  DbMetrics metrics() const;
+
+  void reset_metrics() { metrics_ = {}; }
+
+ private:
+  DbBucket& db_;
+  mutable DbMetrics metrics_;
+};
+
+}  // namespace silkworm
+
+#endif  // SILKWORM_CORE_METERED_DB_BUCKET_HPP_
@@ -16,8 +16,29 @@
 
 #include "miner.hpp"
 
+#include <stdexcept>
+
+#include "storage_sync.hpp"
+
 namespace silkworm {
 
+Miner::Miner(DbBucket& db, const sync::Hints& hints,
+             std::optional<uint32_t> block_height, DbBucket* storage_db)
+    : Node(db, hints, block_height, storage_db) {
+  state_.keep_undo_journal(kMaxReorgDepth);
+  state_.keep_history(kHistoryBlocks);
+  state_.cache_replies(kReplyCacheBytes);
+  if (block_height) {
+    storage_journal_.seal(*block_height);
+  }
+}
+
+void Miner::hash_deeper(uint8_t depth) {
+  if (depth > state_.depth() && depth != state_.hash_depth()) {
+    state_.hash_deeper(depth, kDeepNodeCacheSize);
+  }
+}
+
 void Miner::new_block() {
   if (state_.synced_block() < 0) {
     throw std::runtime_error("not synced yet");
@@ -30,15 +51,98 @@ void Miner::create_account(const Address& address, const Account& account) {
   state_.put(keccak(byte_view(address)), to_rlp(account));
 }
 
+void Miner::delete_account(const Address& address) {
+  const auto account = keccak(byte_view(address));
+  state_.del(account);
+
+  if (storage_db_) {
+    for (const auto& leaf : read_storage(*storage_db_, account)) {
+      const auto full_key =
+          std::string(byte_view(account)) + std::string(byte_view(leaf.first));
+      storage_journal_.record(*storage_db_, full_key);
+      storage_db_->del(full_key, full_key + '\0');
+    }
+    dirty_storage_.erase(account);
+    storage_tries_.erase(account);
+  }
+}
+
+void Miner::set_storage(const Address& address, const Hash& location,
+                        std::string_view value) {
+  if (!storage_db_) {
+    throw std::logic_error("no storage db");
+  }
+
+  const auto account = keccak(byte_view(address));
+  const auto key = keccak(byte_view(location));
+
+  // storage_db keys are account + location
+  const auto full_key =
+      std::string(byte_view(account)) + std::string(byte_view(key));
+  storage_journal_.record(*storage_db_, full_key);
+
+  if (value.empty()) {
+    storage_db_->del(full_key, full_key + '\0');
+  } else {
+    storage_db_->put(full_key, value);
+  }
+
+  dirty_storage_.insert(account);
+}
+
 void Miner::seal_block() {
   if (new_block_ == 0) {
     throw std::logic_error(
         "seal_block must be called exactly once per new_block");
   }
 
+  for (const auto& account : dirty_storage_) {
+    const auto rlp = db_.get(byte_view(account));
+    if (!rlp) {
+      throw std::logic_error("storage of a non-existent account");
+    }
+    auto acc = account_from_rlp(*rlp);
+    acc.storage = storage_root(read_storage(*storage_db_, account));
+    state_.put(account, to_rlp(acc));
+
+    storage_tries_.erase(account);
+  }
+  dirty_storage_.clear();
+
   state_.init_from_db(new_block_);
 
+  for (auto& trie : storage_tries_) {
+    trie.second->state.init_from_db(new_block_);
+  }
+  storage_valid_for_block_ = new_block_;
+  if (storage_db_) {
+    storage_journal_.seal(new_block_);
+  }
+
   new_block_ = 0;
 }
 
+void Miner::unwind(uint32_t num_blocks) {
+  if (new_block_ != 0) {
+    throw std::logic_error("unwind within a block");
+  }
+
+  const auto block = state_.synced_block() - static_cast<int64_t>(num_blocks);
+  if (block < 0) {
+    throw std::out_of_range("unwind beyond the genesis");
+  }
+  state_.unwind(static_cast<uint32_t>(block));
+
+  if (storage_db_) {
+    for (const auto& key : storage_journal_.unwind(
+             *storage_db_, static_cast<uint32_t>(block))) {
+      storage_tries_.erase(string_to_hash(key.substr(0, kHashBytes)));
+    }
+    for (auto& trie : storage_tries_) {
+      trie.second->state.init_from_db(block);
+    }
+    storage_valid_for_block_ = block;
+  }
+}
+
 }  // namespace silkworm
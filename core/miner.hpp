@@ -17,16 +17,35 @@
 #ifndef SILKWORM_CORE_MINER_HPP_
 #define SILKWORM_CORE_MINER_HPP_
 
+#include <set>
+
 #include "account.hpp"
 #include "node.hpp"
+#include "undo_journal.hpp"
 
 namespace silkworm {
 
 class Miner : public Node {
  public:
+  // how many blocks can be unwound
+  static constexpr uint32_t kMaxReorgDepth = 64;
+
+  // how many past blocks leechers can pin their requests to
+  static constexpr uint32_t kHistoryBlocks = 16;
+
+  // of leaves replies served again to leechers asking the same
+  static constexpr size_t kReplyCacheBytes = 64 * 1024 * 1024;
+
+  // of the nodes computed for leechers with a deeper tree, see
+  // State::hash_deeper
+  static constexpr size_t kDeepNodeCacheSize = 64 * 1024;
+
   Miner(DbBucket& db, const sync::Hints& hints,
-        std::optional<uint32_t> block_height)
-      : Node(db, hints, block_height) {}
+        std::optional<uint32_t> block_height, DbBucket* storage_db = nullptr);
+
+  // Serves leechers with a tree of the given depth, if deeper than the
+  // one this miner can afford; see State::hash_deeper. Undone by retune.
+  void hash_deeper(uint8_t depth);
 
   void new_block();
 
@@ -34,10 +53,27 @@ class Miner : public Node {
   // Must be called after new_block and before seal_block.
   void create_account(const Address&, const Account&);
 
+  // Deletes the account together with its storage, if any.
+  // Must be called after new_block and before seal_block.
+  void delete_account(const Address&);
+
+  // Empty value deletes the location. The account must exist by seal_block,
+  // which updates its storage root.
+  // Must be called after new_block and before seal_block.
+  void set_storage(const Address&, const Hash& location,
+                   std::string_view value);
+
   void seal_block();
 
+  // Reverts the last sealed blocks, e.g. to mine on another fork.
+  // Must not be called between new_block and seal_block.
+  void unwind(uint32_t num_blocks);
+
  private:
   uint32_t new_block_ = 0;
+
+  std::set<Hash> dirty_storage_;
+  UndoJournal storage_journal_{kMaxReorgDepth};
 };
 
 }  // namespace silkworm
@@ -16,34 +16,65 @@
 
 #include "mptrie.hpp"
 
-#include "rlp.hpp"
+#include <stdexcept>
+
+namespace {
+
+size_t branch_node_payload_length(std::bitset<16> empty) {
+  return 16 + (16 - empty.count()) * silkworm::kHashBytes;
+}
+
+}  // namespace
 
 namespace silkworm {
 
 void LeafHasher::append(std::string_view, std::string_view val) {
+  append_hash(keccak(val));
+}
+
+void LeafHasher::append_hash(const Hash& val_hash) {
   empty_ = false;
-  joint_leaves_ += byte_view(keccak(val));
+  joint_leaves_ += byte_view(val_hash);
 }
 
 namespace mptrie {
 // https://github.com/ethereum/wiki/wiki/Patricia-Tree
 Hash branch_node_hash(std::bitset<16> empty, const std::array<Hash, 16>& hash) {
-  thread_local rlp::List rlp(16, "");
+  char buf[kMaxBranchNodeRlpSize];
+  const auto end = branch_node_to_rlp(empty, hash, buf);
+  return keccak(std::string_view(buf, end - buf));
+}
+
+size_t branch_node_rlp_length(std::bitset<16> empty) {
+  return rlp::list_encoded_length(branch_node_payload_length(empty));
+}
 
+char* branch_node_to_rlp(std::bitset<16> empty,
+                         const std::array<Hash, 16>& hash, char* out) {
+  out = rlp::encode_list_header(branch_node_payload_length(empty), out);
   for (Nibble i = 0; i < 16; ++i) {
-    auto& str = boost::get<std::string>(rlp[i]);
-    if (empty[i]) {
-      str.clear();
-    } else {
-      str = byte_view(hash[i]);
-    }
+    out = rlp::encode_string(empty[i] ? std::string_view{} : byte_view(hash[i]),
+                             out);
   }
+  return out;
+}
 
-  thread_local std::string out;
-  out.clear();
-  rlp::encode(rlp, out);
-
-  return keccak(out);
+void branch_node_from_rlp(rlp::Reader& in, std::bitset<16>& empty,
+                          std::array<Hash, 16>& hash) {
+  auto items = in.read_list();
+  for (Nibble i = 0; i < 16; ++i) {
+    if (items.empty()) {
+      throw std::invalid_argument("branch node must have 16 items");
+    }
+    const auto item = items.read_string();
+    empty[i] = item.empty();
+    if (!empty[i]) {
+      hash[i] = string_to_hash(item);
+    }
+  }
+  if (!items.empty()) {
+    throw std::invalid_argument("branch node must have 16 items");
+  }
 }
 }  // namespace mptrie
 
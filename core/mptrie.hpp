@@ -24,6 +24,7 @@
 
 #include "common.hpp"
 #include "keccak.hpp"
+#include "rlp.hpp"
 
 // Things related to the Modified Merkle Patricia Trie
 // https://github.com/ethereum/wiki/wiki/Patricia-Tree
@@ -34,6 +35,9 @@ class LeafHasher {
  public:
   void append(std::string_view key, std::string_view val);
 
+  // as append, with keccak(val) computed beforehand
+  void append_hash(const Hash& val_hash);
+
   bool empty() const { return empty_; }
 
   // TODO implement properly (extension nodes, etc)
@@ -49,6 +53,19 @@ namespace mptrie {
 
 Hash branch_node_hash(std::bitset<16> empty, const std::array<Hash, 16>& hash);
 
+// RLP of a branch node without a value: 16 strings, empty or a hash
+static constexpr size_t kMaxBranchNodeRlpSize = 3 + 16 * (1 + kHashBytes);
+
+size_t branch_node_rlp_length(std::bitset<16> empty);
+
+// Returns the end of the output.
+char* branch_node_to_rlp(std::bitset<16> empty,
+                         const std::array<Hash, 16>& hash, char* out);
+
+// throws std::invalid_argument if the next item is not a branch node
+void branch_node_from_rlp(rlp::Reader&, std::bitset<16>& empty,
+                          std::array<Hash, 16>& hash);
+
 }  // namespace mptrie
 
 }  // namespace silkworm
@@ -16,18 +16,19 @@
 
 #include "node.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <type_traits>
 
 namespace {
 
-uint8_t depth(const silkworm::sync::Hints& hints) {
+uint8_t tree_depth(const silkworm::sync::Hints& hints) {
   return std::min(hints.optimal_phase2_depth(), hints.depth_to_fit_in_memory());
 }
 
 uint8_t phase1_depth(const silkworm::sync::Hints& hints) {
-  return std::min(hints.optimal_phase1_depth(), depth(hints));
+  return std::min(hints.optimal_phase1_depth(), tree_depth(hints));
 }
 
 }  // namespace
@@ -35,76 +36,306 @@ uint8_t phase1_depth(const silkworm::sync::Hints& hints) {
 namespace silkworm {
 
 Node::Node(DbBucket& db, const sync::Hints& hints,
-           std::optional<uint32_t> data_valid_for_block)
-    : state_{db, depth(hints), phase1_depth(hints)} {
+           std::optional<uint32_t> data_valid_for_block, DbBucket* storage_db)
+    : db_{db},
+      state_{db, tree_depth(hints), ::phase1_depth(hints)},
+      storage_db_{storage_db} {
   if (data_valid_for_block) {
     state_.init_from_db(*data_valid_for_block);
+    storage_valid_for_block_ = *data_valid_for_block;
   }
 }
 
+sync::Request Node::next_sync_request() {
+  auto request = state_.next_sync_request();
+
+  const auto block = state_.synced_block();
+  if (!std::holds_alternative<std::monostate>(request) || block < 0) {
+    return request;
+  }
+
+  // the state trie is synced, now the storage
+  if (storage_db_ && block != storage_valid_for_block_) {
+    if (!storage_sync_) {
+      // a full scan first, then only the accounts the state sync rewrites
+      storage_sync_.emplace(db_, *storage_db_, block);
+      state_.track_changed_keys();
+    } else if (storage_sync_->block() != static_cast<uint32_t>(block)) {
+      storage_sync_->move_to_block(block, state_.take_changed_keys());
+    }
+    request = storage_sync_->next_sync_request();
+    if (storage_sync_->outdated()) {
+      // the tries synced so far are kept; the rest are looked up again
+      // once the state trie has caught up, or at the same block if the
+      // peer turns out not to have moved on
+      storage_sync_->move_to_block(block, {});
+      state_.resume_sync();
+      return state_.next_sync_request();
+    }
+    if (!std::holds_alternative<std::monostate>(request) ||
+        !storage_sync_->done()) {
+      return request;
+    }
+  }
+
+  if (peer_block_ > block && peer_block_ > resumed_for_block_) {
+    // the peer moved on while we were syncing; catch up with it
+    resumed_for_block_ = peer_block_;
+    state_.resume_sync();
+    return state_.next_sync_request();
+  }
+  return {};
+}
+
 void Node::sync(const Node& peer, sync::Stats& stats, uint64_t max_bytes) {
   // TODO error handling, incl resend of timed-out request
   // TODO separate the wheat from the chaff (good vs bad peers)
   // TODO buffered request/reply dequeue?
 
-  auto& state = state_;
   uint64_t bytes_used = 0;
 
   while (true) {
-    const auto request = state.next_sync_request();
+    const auto request = next_sync_request();
 
     if (std::holds_alternative<std::monostate>(request)) {
       return;
     }
 
-    ++stats.num_requests;
+    const auto reply = peer.reply_to(request);
+    process_reply(request, reply, stats);
+
+    bytes_used += sync::byte_size(reply);
+    if (bytes_used >= max_bytes) {
+      return;
+    }
+  }
+}
+
+sync::Reply Node::reply_to(const sync::Request& request) const {
+  if (auto leaves_request = std::get_if<sync::GetLeavesRequest>(&request)) {
+    if (leaves_request->account) {
+      return get_storage_leaves(*leaves_request);
+    }
+    return get_state_leaves(*leaves_request);
+  } else if (auto node_request = std::get_if<sync::GetNodeRequest>(&request)) {
+    auto reply = node_request->account ? get_storage_nodes(*node_request)
+                                       : get_state_nodes(*node_request);
+    if (!reply) {
+      throw std::runtime_error("Unexpected null NodeReply");
+    }
+    return *reply;
+  } else if (auto storage_request =
+                 std::get_if<sync::GetStorageRequest>(&request)) {
+    return get_storage(*storage_request);
+  }
+  throw std::invalid_argument("empty request");
+}
+
+void Node::verify_replies(unsigned num_threads) {
+  verifier_ = std::make_unique<sync::Verifier>(num_threads);
+}
 
-    if (auto leaves_request = std::get_if<sync::GetLeavesRequest>(&request)) {
-      stats.request_total_bytes += leaves_request->byte_size();
+std::future<sync::Verdict> Node::verify_reply(const sync::Request& request,
+                                              const sync::Reply& reply) const {
+  if (!verifier_) {
+    return {};
+  }
+  return verifier_->submit(request, reply, state_.depth());
+}
 
-      const auto reply = peer.get_state_leaves(*leaves_request);
+void Node::process_reply(const sync::Request& request,
+                         const sync::Reply& reply, sync::Stats& stats) {
+  apply_reply(request, reply, verify_reply(request, reply), stats);
+}
 
-      if (reply.status != sync::LeavesReply::kOK) {
-        std::cerr << "sync error " << reply.status << std::endl;
-        throw std::runtime_error("TODO better error handling");
-      }
+void Node::apply_reply(const sync::Request& request, const sync::Reply& reply,
+                       std::future<sync::Verdict> pending,
+                       sync::Stats& stats) {
+  ++stats.num_requests;
+  stats.request_total_bytes += sync::byte_size(request);
+  stats.reply_total_bytes += sync::byte_size(reply);
+  ++stats.num_replies;
 
-      bytes_used += reply.byte_size();
-      stats.reply_total_bytes += reply.byte_size();
-      stats.reply_total_nodes += reply.proof.size();
-      if (reply.leaves) {
-        stats.reply_total_leaves += reply.leaves->size();
-      }
+  std::optional<sync::Verdict> verdict;
+  if (pending.valid()) {
+    verdict = pending.get();
+    if (!verdict->ok()) {
+      ++stats.num_rejected_replies;
+      return;
+    }
+  }
+  const sync::Verdict* checked = verdict ? &*verdict : nullptr;
 
-      state.process_leaves_reply(leaves_request->prefix, reply);
-    } else if (auto node_request =
-                   std::get_if<sync::GetNodeRequest>(&request)) {
-      stats.request_total_bytes += node_request->byte_size();
+  if (auto leaves_request = std::get_if<sync::GetLeavesRequest>(&request)) {
+    const auto& leaves_reply = std::get<sync::LeavesReply>(reply);
 
-      const auto reply = peer.get_state_nodes(*node_request);
+    if (leaves_reply.status != sync::LeavesReply::kOK) {
+      std::cerr << "sync error " << leaves_reply.status << std::endl;
+      throw std::runtime_error("TODO better error handling");
+    }
 
-      if (!reply) {
-        throw std::runtime_error("Unexpected null NodeReply");
+    bool applied = true;
+    if (leaves_request->account) {
+      if (storage_sync_) {
+        applied = storage_sync_->process_leaves_reply(*leaves_request,
+                                                      leaves_reply, checked);
       }
+    } else {
+      applied = state_.process_leaves_reply(leaves_request->prefix,
+                                            leaves_reply, checked);
+    }
+    if (!applied) {
+      ++stats.num_rejected_replies;
+      return;
+    }
 
-      bytes_used += reply->byte_size();
-      stats.reply_total_bytes += reply->byte_size();
-      stats.reply_total_nodes += reply->nodes.size();
+    stats.reply_total_nodes += leaves_reply.proof.size();
+    peer_block_ =
+        std::max(peer_block_, static_cast<int32_t>(leaves_reply.head_block));
 
-      state.process_node_reply(*node_request, *reply);
+    if (leaves_reply.leaves && leaves_request->account) {
+      stats.reply_total_storage_leaves += leaves_reply.leaves->size();
+    } else if (leaves_reply.leaves) {
+      const auto& leaves = *leaves_reply.leaves;
+      stats.reply_total_leaves += leaves.size();
+      stats.reply_total_leaf_bytes +=
+          leaves.size() * kHashBytes + leaves.value_bytes();
     }
+  } else if (auto node_request = std::get_if<sync::GetNodeRequest>(&request)) {
+    // TODO verify nodes against their parents
+    const auto& node_reply = std::get<sync::NodeReply>(reply);
 
-    ++stats.num_replies;
+    stats.reply_total_nodes += node_reply.nodes.size();
 
-    if (bytes_used >= max_bytes) {
-      return;
+    peer_block_ =
+        std::max(peer_block_, static_cast<int32_t>(node_reply.head_block));
+
+    if (!node_request->account) {
+      state_.process_node_reply(*node_request, node_reply);
+    } else if (storage_sync_) {
+      storage_sync_->process_node_reply(*node_request, node_reply);
+    }
+  } else if (auto storage_request =
+                 std::get_if<sync::GetStorageRequest>(&request)) {
+    const auto& storage_reply = std::get<sync::StorageReply>(reply);
+
+    for (const auto& storage : storage_reply.storage) {
+      stats.reply_total_storage_leaves += storage.leaves.size();
+    }
+
+    peer_block_ = std::max(peer_block_,
+                           static_cast<int32_t>(storage_reply.block_number));
+
+    if (storage_sync_) {
+      storage_sync_->process_storage_reply(*storage_request, storage_reply);
     }
   }
-  return;
+}
+
+void Node::retune(const sync::Hints& hints) {
+  if (tree_depth(hints) == state_.depth()) {
+    state_.set_phase1_depth(::phase1_depth(hints));
+    return;
+  }
+
+  const auto block = state_.synced_block();
+  state_.restructure(tree_depth(hints), ::phase1_depth(hints));
+  if (block >= 0) {
+    state_.init_from_db(block);
+  }
 }
 
 bool Node::phase1_sync_done() const { return state_.phase1_sync_done(); }
 
-bool Node::sync_done() const { return state_.synced_block() >= 0; }
+bool Node::sync_done() const {
+  const auto block = state_.synced_block();
+  if (block < 0) {
+    return false;
+  }
+  if (peer_block_ > block) {
+    return false;
+  }
+  if (!storage_db_ || block == storage_valid_for_block_) {
+    return true;
+  }
+  return storage_sync_ &&
+         storage_sync_->block() == static_cast<uint32_t>(block) &&
+         storage_sync_->done();
+}
+
+sync::StorageReply Node::get_storage(
+    const sync::GetStorageRequest& request) const {
+  sync::StorageReply reply;
+  reply.storage.resize(request.accounts.size());
+
+  const auto block = state_.synced_block();
+  if (!storage_db_ || block < 0 ||
+      (request.block_number &&
+       static_cast<int32_t>(*request.block_number) > block)) {
+    for (auto& storage : reply.storage) {
+      storage.status = sync::LeavesReply::kDontHaveData;
+    }
+    return reply;
+  }
+
+  reply.block_number = block;
+
+  size_t leaves_left = sync::kMaxLeavesPerStorageReply;
+
+  for (size_t i = 0; i < request.accounts.size(); ++i) {
+    auto& storage = reply.storage[i];
+
+    uint64_t num_leaves = 0;
+    PrefixedDbBucket(*storage_db_, byte_view(request.accounts[i]))
+        .get("", {},
+             [&storage, &num_leaves, leaves_left](std::string_view key,
+                                                  std::string_view val) {
+               if (++num_leaves <= leaves_left) {
+                 storage.leaves.emplace_back(string_to_hash(key), val);
+               }
+             });
+
+    if (num_leaves > sync::kMaxLeavesPerStorageReply) {
+      storage.status = sync::LeavesReply::kTooManyLeaves;
+      storage.num_leaves = num_leaves;
+      storage.leaves.clear();
+    } else if (num_leaves > leaves_left) {
+      storage.status = sync::LeavesReply::kDontHaveData;
+      storage.leaves.clear();
+    } else {
+      leaves_left -= num_leaves;
+    }
+  }
+
+  return reply;
+}
+
+const State& Node::storage_trie(const Hash& account) const {
+  auto& trie = storage_tries_[account];
+  if (!trie) {
+    trie = std::make_unique<StorageTrie>(*storage_db_, account,
+                                         sync::kStorageTrieDepth);
+    trie->state.init_from_db(state_.synced_block());
+  }
+  return trie->state;
+}
+
+sync::LeavesReply Node::get_storage_leaves(
+    const sync::GetLeavesRequest& request) const {
+  if (!storage_db_ || state_.synced_block() < 0) {
+    sync::LeavesReply reply;
+    reply.status = sync::LeavesReply::kDontHaveData;
+    return reply;
+  }
+  return storage_trie(*request.account).get_leaves(request);
+}
+
+std::optional<sync::NodeReply> Node::get_storage_nodes(
+    const sync::GetNodeRequest& request) const {
+  if (!storage_db_ || state_.synced_block() < 0) {
+    return {};
+  }
+  return storage_trie(*request.account).get_nodes(request);
+}
 
 }  // namespace silkworm
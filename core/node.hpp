@@ -17,28 +17,73 @@
 #ifndef SILKWORM_CORE_NODE_HPP_
 #define SILKWORM_CORE_NODE_HPP_
 
+#include <future>
+#include <map>
+#include <memory>
 #include <optional>
 #include <variant>
 
 #include "db_bucket.hpp"
 #include "state.hpp"
+#include "storage_sync.hpp"
 #include "sync.hpp"
+#include "verifier.hpp"
 
 namespace silkworm {
 
 class Node {
  public:
+  // Storage tries are only synced if storage_db is given.
   Node(DbBucket& db, const sync::Hints&,
-       std::optional<uint32_t> data_valid_for_block);
+       std::optional<uint32_t> data_valid_for_block,
+       DbBucket* storage_db = nullptr);
 
   // TODO multiple peers
   void sync(const Node& peer, sync::Stats& stats, uint64_t max_bytes);
 
+  // Single steps of sync() for callers that deliver requests and replies
+  // themselves, e.g. over a modelled network.
+  sync::Request next_sync_request();
+
+  // Not thread-safe, see State::get_leaves; the storage tries are
+  // created on demand too.
+  sync::Reply reply_to(const sync::Request&) const;
+
+  void process_reply(const sync::Request&, const sync::Reply&,
+                     sync::Stats& stats);
+
+  // Checks replies before they are applied, on num_threads threads
+  // or on the calling one if zero; replies failing are counted and dropped.
+  void verify_replies(unsigned num_threads);
+
+  // Times the sync steps of the state trie, if not null.
+  void set_profiler(sync::Profiler* profiler) { state_.set_profiler(profiler); }
+
+  // process_reply split into stages so that a reply can be checked while
+  // earlier ones are applied. verify_reply returns an invalid future unless
+  // replies are verified; the request and the reply must outlive it.
+  std::future<sync::Verdict> verify_reply(const sync::Request&,
+                                          const sync::Reply&) const;
+
+  void apply_reply(const sync::Request&, const sync::Reply&,
+                   std::future<sync::Verdict>, sync::Stats& stats);
+
   bool phase1_sync_done() const;
 
   bool sync_done() const;
 
-  // TODO storage sync
+  uint8_t depth() const { return state_.depth(); }
+
+  uint8_t phase1_depth() const { return state_.phase1_depth(); }
+
+  // seeder side, see State::cache_replies
+  const ReplyCache* reply_cache() const { return state_.reply_cache(); }
+
+  // Switches to the tree depths optimal for the given hints.
+  // A synced node stays synced; otherwise phase 2 revalidates the data
+  // already downloaded. Peers must agree on the depth for proofs to match.
+  void retune(const sync::Hints&);
+
   sync::LeavesReply get_state_leaves(sync::GetLeavesRequest request) const {
     return state_.get_leaves(request);
   }
@@ -48,8 +93,31 @@ class Node {
     return state_.get_nodes(request);
   }
 
+  sync::StorageReply get_storage(const sync::GetStorageRequest&) const;
+
+  sync::LeavesReply get_storage_leaves(const sync::GetLeavesRequest&) const;
+
+  std::optional<sync::NodeReply> get_storage_nodes(
+      const sync::GetNodeRequest&) const;
+
  protected:
+  DbBucket& db_;
   State state_;
+
+  DbBucket* storage_db_;
+  int64_t storage_valid_for_block_ = -1;
+
+  // Seeder side: large storage tries, created on demand
+  // and kept at the block of the state trie.
+  mutable std::map<Hash, std::unique_ptr<StorageTrie>> storage_tries_;
+
+  const State& storage_trie(const Hash& account) const;
+
+  // leecher side
+  std::optional<StorageSync> storage_sync_;
+  int32_t peer_block_ = -1;  // newest block the peer has told us about
+  int32_t resumed_for_block_ = -1;
+  std::unique_ptr<sync::Verifier> verifier_;
 };
 
 }  // namespace silkworm
@@ -0,0 +1,61 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "node_cache.hpp"
+
+namespace silkworm {
+
+const sync::Proof* NodeCache::find(const Prefix prefix) {
+  const auto it = index_.find({prefix.size(), prefix.val()});
+  if (it == index_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return &it->second->second;
+}
+
+void NodeCache::insert(const Prefix prefix, const sync::Proof& node) {
+  const Key key{prefix.size(), prefix.val()};
+  if (max_nodes_ == 0 || index_.count(key)) {
+    return;
+  }
+  if (index_.size() == max_nodes_) {
+    index_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+
+  lru_.emplace_front(key, node);
+  index_.emplace(key, lru_.begin());
+}
+
+void NodeCache::invalidate(const Hash& leaf_key) {
+  for (uint8_t size = 0; size <= 16 && !index_.empty(); ++size) {
+    const auto it = index_.find({size, Prefix(size, leaf_key).val()});
+    if (it != index_.end()) {
+      lru_.erase(it->second);
+      index_.erase(it);
+    }
+  }
+}
+
+void NodeCache::clear() {
+  index_.clear();
+  lru_.clear();
+}
+
+}  // namespace silkworm
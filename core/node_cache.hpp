@@ -0,0 +1,66 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_NODE_CACHE_HPP_
+#define SILKWORM_CORE_NODE_CACHE_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <utility>
+
+#include "prefix.hpp"
+#include "sync.hpp"
+
+namespace silkworm {
+
+// Nodes a seeder computed from the db rather than keeps in memory,
+// see State::hash_deeper. A node is dropped once a leaf below it changes,
+// or when it's the least recently used one over the limit.
+class NodeCache {
+ public:
+  explicit NodeCache(size_t max_nodes) : max_nodes_{max_nodes} {}
+
+  // null if not cached
+  const sync::Proof* find(Prefix);
+
+  void insert(Prefix, const sync::Proof&);
+
+  // Drops the nodes on the path of the leaf.
+  void invalidate(const Hash& leaf_key);
+
+  void clear();
+
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+  size_t size() const { return index_.size(); }
+
+ private:
+  using Key = std::pair<uint8_t, uint64_t>;  // prefix size & value
+  using Entry = std::pair<Key, sync::Proof>;
+
+  std::list<Entry> lru_;  // most recently used first
+  std::map<Key, std::list<Entry>::iterator> index_;
+
+  size_t max_nodes_;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+
+}  // namespace silkworm
+
+#endif  // SILKWORM_CORE_NODE_CACHE_HPP_
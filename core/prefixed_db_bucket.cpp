@@ -0,0 +1,75 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "prefixed_db_bucket.hpp"
+
+namespace silkworm {
+
+void PrefixedDbBucket::put(std::string_view key, std::string_view val) {
+  db_.put(full_key(key), val);
+}
+
+void PrefixedDbBucket::put(const std::function<std::optional<KeyVal>()>& gen) {
+  std::string key;
+  db_.put([this, &gen, &key]() -> std::optional<KeyVal> {
+    const auto entry = gen();
+    if (!entry) {
+      return {};
+    }
+    key = full_key(entry->first);
+    return KeyVal{key, entry->second};
+  });
+}
+
+std::optional<std::string_view> PrefixedDbBucket::get(
+    std::string_view key) const {
+  return db_.get(full_key(key));
+}
+
+void PrefixedDbBucket::get(
+    std::string_view lower, std::optional<std::string_view> upper,
+    const std::function<void(std::string_view, std::string_view)>& f) const {
+  const auto prefix_size = prefix_.size();
+  db_.get(full_key(lower), full_upper(upper),
+          [prefix_size, &f](std::string_view key, std::string_view val) {
+            f(key.substr(prefix_size), val);
+          });
+}
+
+void PrefixedDbBucket::del(std::string_view lower,
+                           std::optional<std::string_view> upper) {
+  db_.del(full_key(lower), full_upper(upper));
+}
+
+std::optional<std::string> PrefixedDbBucket::full_upper(
+    std::optional<std::string_view> upper) const {
+  if (upper) {
+    return full_key(*upper);
+  }
+
+  // the smallest key greater than all keys starting with the prefix
+  std::string next = prefix_;
+  while (!next.empty() && static_cast<uint8_t>(next.back()) == 0xff) {
+    next.pop_back();
+  }
+  if (next.empty()) {
+    return {};
+  }
+  ++next.back();
+  return next;
+}
+
+}  // namespace silkworm
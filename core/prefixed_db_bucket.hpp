@@ -0,0 +1,69 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_PREFIXED_DB_BUCKET_HPP_
+#define SILKWORM_CORE_PREFIXED_DB_BUCKET_HPP_
+
+#include <string>
+
+#include "db_bucket.hpp"
+
+namespace silkworm {
+
+// View of the entries of another bucket whose keys start with a given
+// prefix, with the prefix stripped from the keys,
+// e.g. the storage of one account in a bucket holding all storage tries.
+class PrefixedDbBucket : public DbBucket {
+ public:
+  PrefixedDbBucket(DbBucket& db, std::string_view prefix)
+      : db_(db), prefix_(prefix) {}
+
+  virtual ~PrefixedDbBucket() = default;
+
+  void put(std::string_view key, std::string_view val) override;
+
+  void put(const std::function<std::optional<KeyVal>()>& gen) override;
+
+  std::optional<std::string_view> get(std::string_view key) const override;
+
+  // Iterate over entries with lower <= key < upper
+  // and call f(key, val) for each entry.
+  void get(std::string_view lower, std::optional<std::string_view> upper,
+           const std::function<void(std::string_view, std::string_view)>& f)
+      const override;
+
+  // Delete all entries with lower <= key < upper.
+  void del(std::string_view lower,
+           std::optional<std::string_view> upper) override;
+
+  std::shared_ptr<const void> pin() const override { return db_.pin(); }
+
+ private:
+  DbBucket& db_;
+  std::string prefix_;
+
+  std::string full_key(std::string_view key) const {
+    return prefix_ + std::string(key);
+  }
+
+  // upper bound of the full key range corresponding to upper
+  std::optional<std::string> full_upper(
+      std::optional<std::string_view> upper) const;
+};
+
+}  // namespace silkworm
+
+#endif  // SILKWORM_CORE_PREFIXED_DB_BUCKET_HPP_
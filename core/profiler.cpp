@@ -0,0 +1,141 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+
+#include "bits.hpp"
+
+namespace silkworm::sync {
+
+const char* Profiler::name(Span span) {
+  switch (span) {
+    case kNextRequest:
+      return "next request";
+    case kLeavesReply:
+      return "leaves reply";
+    case kNodeReply:
+      return "node reply";
+    case kDbWrite:
+      return "db write";
+    case kHashing:
+      return "hashing";
+    case kNumSpans:
+      break;
+  }
+  return "?";
+}
+
+void Profiler::Histogram::add(Nanoseconds duration) {
+  // zero, e.g. from a coarse clock, goes into the first bucket as well
+  const auto ns = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+  const unsigned bucket = ns ? 63 - count_leading_zeros(ns) : 0;
+  ++buckets_[std::min(bucket, kNumBuckets - 1)];
+  ++count_;
+  total_ += duration;
+  max_ = std::max(max_, duration);
+}
+
+Profiler::Nanoseconds Profiler::Histogram::quantile(double q) const {
+  const auto rank = static_cast<uint64_t>(std::ceil(q * count_));
+  uint64_t seen = 0;
+  for (unsigned i = 0; i < kNumBuckets; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank && seen > 0) {
+      return std::min(Nanoseconds(2ll << i), max_);
+    }
+  }
+  return max_;
+}
+
+void Profiler::enable_trace(size_t max_events) { max_events_ = max_events; }
+
+void Profiler::record(Span span, unsigned phase, Clock::time_point start,
+                      Nanoseconds wall_time, Nanoseconds cpu_time) {
+  latency_[phase - 1][span].add(wall_time);
+  cpu_time_[phase - 1][span] += cpu_time;
+
+  if (events_.size() < max_events_) {
+    events_.push_back({span, phase, start, wall_time});
+  } else if (max_events_) {
+    ++dropped_events_;
+  }
+}
+
+void Profiler::print(std::ostream& out) const {
+  const auto ms = [](Nanoseconds x) { return x.count() * 1e-6; };
+  const auto us = [](Nanoseconds x) { return x.count() * 1e-3; };
+
+  out << std::left << std::setw(14) << "span" << std::right << std::setw(6)
+      << "phase" << std::setw(10) << "count" << std::setw(12) << "total ms"
+      << std::setw(12) << "CPU ms" << std::setw(10) << "mean us"
+      << std::setw(10) << "p50 us" << std::setw(10) << "p99 us"
+      << std::setw(10) << "max us" << '\n'
+      << std::fixed << std::setprecision(1);
+
+  for (unsigned phase = 1; phase <= kNumPhases; ++phase) {
+    for (unsigned i = 0; i < kNumSpans; ++i) {
+      const auto span = static_cast<Span>(i);
+      const auto& h = latency(span, phase);
+      if (h.count() == 0) {
+        continue;
+      }
+      out << std::left << std::setw(14) << name(span) << std::right
+          << std::setw(6) << phase << std::setw(10) << h.count()
+          << std::setw(12) << ms(h.total()) << std::setw(12)
+          << ms(cpu_time(span, phase)) << std::setw(10)
+          << us(h.total()) / h.count() << std::setw(10) << us(h.quantile(0.5))
+          << std::setw(10) << us(h.quantile(0.99)) << std::setw(10)
+          << us(h.max()) << '\n';
+    }
+  }
+  out << std::defaultfloat;
+
+  if (dropped_events_) {
+    out << dropped_events_ << " trace events dropped\n";
+  }
+}
+
+void Profiler::write_trace(std::ostream& out) const {
+  const auto us = [](Nanoseconds x) { return x.count() * 1e-3; };
+
+  out << "{\"traceEvents\":[" << std::fixed << std::setprecision(3);
+  for (size_t i = 0; i < events_.size(); ++i) {
+    const auto& e = events_[i];
+    out << (i ? ",\n" : "\n") << "{\"name\":\"" << name(e.span)
+        << "\",\"cat\":\"phase" << e.phase
+        << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+        << us(e.start - created_) << ",\"dur\":" << us(e.duration) << '}';
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n" << std::defaultfloat;
+}
+
+Profiler::Nanoseconds Profiler::thread_cpu_time() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return std::chrono::seconds(ts.tv_sec) + Nanoseconds(ts.tv_nsec);
+#else
+  return std::chrono::duration_cast<Nanoseconds>(
+      std::chrono::duration<double>(std::clock() / double{CLOCKS_PER_SEC}));
+#endif
+}
+
+}  // namespace silkworm::sync
@@ -0,0 +1,140 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_PROFILER_HPP_
+#define SILKWORM_CORE_PROFILER_HPP_
+
+#include <array>
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+// Where the leecher spends its time in phase 1 vs phase 2, without an
+// external profiler. Spans nest, e.g. hashing within a leaves reply, and
+// each is accounted for in full.
+
+namespace silkworm::sync {
+
+class Profiler {
+ public:
+  enum Span {
+    kNextRequest,
+    kLeavesReply,
+    kNodeReply,
+    kDbWrite,
+    kHashing,
+    kNumSpans,
+  };
+
+  static const char* name(Span);
+
+  // 1 or 2
+  static constexpr unsigned kNumPhases = 2;
+
+  using Clock = std::chrono::steady_clock;
+  using Nanoseconds = std::chrono::nanoseconds;
+
+  // of durations, in power of 2 buckets
+  class Histogram {
+   public:
+    void add(Nanoseconds);
+
+    uint64_t count() const { return count_; }
+    Nanoseconds total() const { return total_; }
+    Nanoseconds max() const { return max_; }
+
+    // upper bound of the bucket the quantile falls into; q in [0, 1]
+    Nanoseconds quantile(double q) const;
+
+   private:
+    static constexpr unsigned kNumBuckets = 48;
+    std::array<uint64_t, kNumBuckets> buckets_{};
+    uint64_t count_ = 0;
+    Nanoseconds total_{0};
+    Nanoseconds max_{0};
+  };
+
+  // Times the enclosing block; does nothing without a profiler.
+  class Scope {
+   public:
+    Scope(Profiler* profiler, Span span, unsigned phase)
+        : profiler_{profiler}, span_{span}, phase_{phase} {
+      if (profiler_) {
+        start_ = Clock::now();
+        cpu_start_ = thread_cpu_time();
+      }
+    }
+
+    ~Scope() {
+      if (profiler_) {
+        profiler_->record(span_, phase_, start_, Clock::now() - start_,
+                          thread_cpu_time() - cpu_start_);
+      }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    Profiler* profiler_;
+    Span span_;
+    unsigned phase_;
+    Clock::time_point start_;
+    Nanoseconds cpu_start_{0};
+  };
+
+  // Keeps up to max_events spans for write_trace.
+  void enable_trace(size_t max_events = 1'000'000);
+
+  void record(Span, unsigned phase, Clock::time_point start,
+              Nanoseconds wall_time, Nanoseconds cpu_time);
+
+  const Histogram& latency(Span span, unsigned phase) const {
+    return latency_[phase - 1][span];
+  }
+
+  Nanoseconds cpu_time(Span span, unsigned phase) const {
+    return cpu_time_[phase - 1][span];
+  }
+
+  // a table of the spans per phase
+  void print(std::ostream&) const;
+
+  // Chrome trace event format, for about:tracing or Perfetto
+  void write_trace(std::ostream&) const;
+
+  static Nanoseconds thread_cpu_time();
+
+ private:
+  std::array<std::array<Histogram, kNumSpans>, kNumPhases> latency_;
+  std::array<std::array<Nanoseconds, kNumSpans>, kNumPhases> cpu_time_{};
+
+  struct Event {
+    Span span;
+    unsigned phase;
+    Clock::time_point start;
+    Nanoseconds duration;
+  };
+
+  Clock::time_point created_ = Clock::now();
+  size_t max_events_ = 0;
+  uint64_t dropped_events_ = 0;
+  std::vector<Event> events_;
+};
+
+}  // namespace silkworm::sync
+
+#endif  // SILKWORM_CORE_PROFILER_HPP_
@@ -0,0 +1,81 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "reply_cache.hpp"
+
+#include <tuple>
+
+namespace silkworm {
+
+bool ReplyCache::Less::operator()(const Key& a, const Key& b) const {
+  return std::make_tuple(a.from_level, a.prefix.val(), a.prefix.size(),
+                         a.hash) < std::make_tuple(b.from_level,
+                                                   b.prefix.val(),
+                                                   b.prefix.size(), b.hash);
+}
+
+const sync::LeavesReply* ReplyCache::find(const Key& key) {
+  const auto it = index_.find(key);
+  if (it == index_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return &it->second->second;
+}
+
+void ReplyCache::insert(const Key& key, sync::LeavesReply reply) {
+  const auto size = reply.byte_size();
+  if (size > max_bytes_ || index_.count(key)) {
+    return;
+  }
+  while (bytes_ + size > max_bytes_) {
+    erase(index_.find(lru_.back().first));
+  }
+
+  lru_.emplace_front(key, std::move(reply));
+  index_.emplace(key, lru_.begin());
+  bytes_ += size;
+}
+
+void ReplyCache::invalidate(const Hash& leaf_key) {
+  for (uint8_t level = 0; level <= 16 && !index_.empty(); ++level) {
+    const Prefix top(level, leaf_key);
+    const auto mask = level ? ~0ull << (64 - 4 * level) : 0;
+
+    auto it = index_.lower_bound(Key{top, level, {}});
+    while (it != index_.end() && it->first.from_level == level &&
+           (it->first.prefix.val() & mask) == top.val()) {
+      erase(it++);
+    }
+  }
+}
+
+void ReplyCache::clear() {
+  index_.clear();
+  lru_.clear();
+  bytes_ = 0;
+}
+
+void ReplyCache::erase(
+    std::map<Key, std::list<Entry>::iterator, Less>::iterator it) {
+  bytes_ -= it->second->second.byte_size();
+  lru_.erase(it->second);
+  index_.erase(it);
+}
+
+}  // namespace silkworm
@@ -0,0 +1,82 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_REPLY_CACHE_HPP_
+#define SILKWORM_CORE_REPLY_CACHE_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <optional>
+#include <utility>
+
+#include "prefix.hpp"
+#include "sync.hpp"
+
+namespace silkworm {
+
+// Leaves replies of the current tree of a seeder, so that a prefix that
+// many leechers ask for is scanned and proven once rather than for each.
+// A reply is dropped once a leaf under the top node of its proof changes,
+// or when the least recently used ones exceed the size limit.
+class ReplyCache {
+ public:
+  struct Key {
+    Prefix prefix;
+    uint8_t from_level;  // of the proof
+    std::optional<Hash> hash;  // see GetLeavesRequest
+  };
+
+  explicit ReplyCache(size_t max_bytes) : max_bytes_{max_bytes} {}
+
+  // null if not cached
+  const sync::LeavesReply* find(const Key&);
+
+  void insert(const Key&, sync::LeavesReply);
+
+  // Drops the replies whose proof or leaves change with the leaf.
+  void invalidate(const Hash& leaf_key);
+
+  void clear();
+
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+  size_t bytes() const { return bytes_; }
+
+ private:
+  // By from_level first, so that the replies a leaf invalidates are
+  // a range of keys per level.
+  struct Less {
+    bool operator()(const Key&, const Key&) const;
+  };
+
+  using Entry = std::pair<Key, sync::LeavesReply>;
+
+  std::list<Entry> lru_;  // most recently used first
+  std::map<Key, std::list<Entry>::iterator, Less> index_;
+
+  size_t max_bytes_;
+  size_t bytes_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+
+  void erase(std::map<Key, std::list<Entry>::iterator, Less>::iterator);
+};
+
+}  // namespace silkworm
+
+#endif  // SILKWORM_CORE_REPLY_CACHE_HPP_
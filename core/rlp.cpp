@@ -16,11 +16,13 @@
 
 #include "rlp.hpp"
 
+#include <cstring>
 #include <iterator>
-#include <optional>
 #include <stdexcept>
 #include <utility>
 
+#include "bits.hpp"
+
 namespace {
 using namespace silkworm::rlp;
 
@@ -37,36 +39,42 @@ struct Comparator : public boost::static_visitor<bool> {
   }
 };
 
-std::string encode_length(uint64_t len, char offset) {
-  if (len < 56) {
-    return {static_cast<char>(len + offset)};
-  } else {
-    const auto bl = to_big_endian(len);
-    return static_cast<char>(bl.length() + offset + 55) + bl;
+void store_big_endian(uint64_t x, char* out) {
+  if (silkworm::kLittleEndian) {
+    x = silkworm::byte_swap(x);
   }
+  std::memcpy(out, &x, 8);
 }
 
-size_t big_endian_length(uint64_t x) {
-  size_t len = 0;
-  for (; x != 0; x /= 256) {
-    ++len;
+uint64_t load_big_endian(const char* in) {
+  uint64_t x;
+  std::memcpy(&x, in, 8);
+  if (silkworm::kLittleEndian) {
+    x = silkworm::byte_swap(x);
   }
-  return len;
+  return x;
 }
 
 size_t length_of_length(uint64_t len) {
   return len < 56 ? 1 : 1 + big_endian_length(len);
 }
 
-struct LengthEncoder : public boost::static_visitor<size_t> {
-  size_t operator()(const std::string& in) const {
-    size_t len = in.length();
+char* encode_length(uint64_t len, unsigned char offset, char* out) {
+  if (len < 56) {
+    *out++ = static_cast<char>(len + offset);
+    return out;
+  }
+  *out++ = static_cast<char>(big_endian_length(len) + offset + 55);
+  return to_big_endian(len, out);
+}
 
-    if (in.length() != 1 || static_cast<unsigned>(in[0]) >= 0x80) {
-      len += length_of_length(in.length());
-    }
+bool is_single_byte(std::string_view in) {
+  return in.length() == 1 && static_cast<unsigned char>(in[0]) < 0x80;
+}
 
-    return len;
+struct LengthEncoder : public boost::static_visitor<size_t> {
+  size_t operator()(const std::string& in) const {
+    return string_encoded_length(in);
   }
 
   size_t operator()(const List& in) const {
@@ -74,146 +82,235 @@ struct LengthEncoder : public boost::static_visitor<size_t> {
     for (const auto& item : in) {
       len += boost::apply_visitor(LengthEncoder(), item);
     }
-    return length_of_length(len) + len;
+    return list_encoded_length(len);
   }
 };
 
-class Encoder : public boost::static_visitor<> {
+// Writes back to front so that the payload length of every list is known
+// by the time its header is written, in a single pass.
+class BackwardEncoder : public boost::static_visitor<char*> {
  public:
-  explicit Encoder(std::string& out) : out_(out){};
-
-  void operator()(const std::string& in) const {
-    if (in.length() != 1 || static_cast<unsigned>(in[0]) >= 0x80) {
-      out_ += encode_length(in.length(), '\x80');
-    }
+  explicit BackwardEncoder(char* end) : end_(end) {}
 
-    out_ += in;
+  char* operator()(const std::string& in) const {
+    const auto begin = end_ - string_encoded_length(in);
+    encode_string(in, begin);
+    return begin;
   }
 
-  void operator()(const List& in) const {
-    size_t len = 0;
-    for (const auto& item : in) {
-      len += boost::apply_visitor(LengthEncoder(), item);
-    }
-    out_ += encode_length(len, '\xc0');
-
-    for (const auto& item : in) {
-      encode(item, out_);
+  char* operator()(const List& in) const {
+    auto begin = end_;
+    for (auto it = in.rbegin(); it != in.rend(); ++it) {
+      begin = boost::apply_visitor(BackwardEncoder(begin), *it);
     }
+    const auto payload_length = static_cast<size_t>(end_ - begin);
+    begin -= length_of_length(payload_length);
+    encode_list_header(payload_length, begin);
+    return begin;
   }
 
  private:
-  std::string& out_;
+  char* end_;
 };
 
-struct DecodedLength {
-  size_t data_len = 0;
-  bool is_str = false;
-};
+Item decode_item(Reader& reader) {
+  if (!reader.next_is_list()) {
+    return std::string{reader.read_string()};
+  }
+  auto items = reader.read_list();
+  List list;
+  while (!items.empty()) {
+    list.push_back(decode_item(items));
+  }
+  return list;
+}
+
+}  // namespace
+
+namespace silkworm::rlp {
+
+void encode(const Item& in, std::string& out) {
+  const auto len = encoded_length(in);
+  const auto pos = out.size();
+  out.resize(pos + len);
+  boost::apply_visitor(BackwardEncoder(&out[pos] + len), in);
+}
+
+size_t encoded_length(const Item& in) {
+  return boost::apply_visitor(LengthEncoder(), in);
+}
+
+char* encode_into(const Item& in, char* out) {
+  const auto end = out + encoded_length(in);
+  boost::apply_visitor(BackwardEncoder(end), in);
+  return end;
+}
 
-DecodedLength decode_length(std::string_view& input) {
-  if (input.empty()) {
+size_t string_encoded_length(std::string_view in) {
+  if (is_single_byte(in)) {
+    return 1;
+  }
+  return length_of_length(in.length()) + in.length();
+}
+
+size_t list_encoded_length(size_t payload_length) {
+  return length_of_length(payload_length) + payload_length;
+}
+
+char* encode_string(std::string_view in, char* out) {
+  if (!is_single_byte(in)) {
+    out = encode_length(in.length(), 0x80, out);
+  }
+  std::memcpy(out, in.data(), in.length());
+  return out + in.length();
+}
+
+char* encode_list_header(size_t payload_length, char* out) {
+  return encode_length(payload_length, 0xc0, out);
+}
+
+Item decode(std::string_view input) {
+  Reader reader(input);
+  auto output = decode_item(reader);
+  if (!reader.empty()) {
+    throw std::invalid_argument("extra input");
+  }
+  return output;
+}
+
+bool Reader::next_is_list() const {
+  if (in_.empty()) {
     throw std::invalid_argument("input is null");
   }
+  return static_cast<unsigned char>(in_[0]) >= 0xc0;
+}
 
-  const unsigned char prefix = input[0];
+std::string_view Reader::read(bool& is_list) {
+  if (in_.empty()) {
+    throw std::invalid_argument("input is null");
+  }
 
+  const unsigned char prefix = in_[0];
   if (prefix <= 0x7f) {
-    return {1, true};
+    is_list = false;
+    const auto payload = in_.substr(0, 1);
+    in_.remove_prefix(1);
+    return payload;
   }
+  in_.remove_prefix(1);
 
-  input.remove_prefix(1);
+  is_list = prefix >= 0xc0;
+  const unsigned short_limit = is_list ? 0xf7 : 0xb7;
+  const unsigned offset = is_list ? 0xc0 : 0x80;
 
-  if (prefix <= 0xb7) {
-    const auto str_len = prefix - 0x80u;
-    if (input.length() < str_len) {
-      throw std::invalid_argument("truncated string");
-    }
-    return {str_len, true};
-  } else if (prefix <= 0xbf) {
-    const auto len_of_len = prefix - 0xb7u;
-    if (input.length() < len_of_len) {
-      throw std::invalid_argument("truncated length");
-    }
-    const auto str_len = from_big_endian(input.substr(0, len_of_len));
-    input.remove_prefix(len_of_len);
-    if (input.length() < str_len) {
-      throw std::invalid_argument("truncated string");
-    }
-    return {str_len, true};
-  } else if (prefix <= 0xf7) {
-    const auto list_len = prefix - 0xc0u;
-    if (input.length() < list_len) {
-      throw std::invalid_argument("truncated list");
-    }
-    return {list_len, false};
+  size_t len = 0;
+  if (prefix <= short_limit) {
+    len = prefix - offset;
   } else {
-    const auto len_of_len = prefix - 0xf7u;
-    if (input.length() < len_of_len) {
+    const auto len_of_len = prefix - short_limit;
+    if (in_.length() < len_of_len) {
       throw std::invalid_argument("truncated length");
     }
-    const auto list_len = from_big_endian(input.substr(0, len_of_len));
-    input.remove_prefix(len_of_len);
-    if (input.length() < list_len) {
-      throw std::invalid_argument("truncated list");
+    if (in_[0] == '\0') {
+      throw std::invalid_argument("length with leading zeroes");
+    }
+    len = from_big_endian(in_.substr(0, len_of_len));
+    in_.remove_prefix(len_of_len);
+    if (len < 56) {
+      throw std::invalid_argument("long form of a short length");
     }
-    return {list_len, false};
   }
-}
 
-std::optional<Item> decode_impl(std::string_view& input) {
-  if (input.empty()) {
-    return {};
+  if (in_.length() < len) {
+    throw std::invalid_argument(is_list ? "truncated list"
+                                        : "truncated string");
   }
-
-  const auto x = decode_length(input);
-  std::string_view sub_view = input.substr(0, x.data_len);
-
-  Item output;
-  if (x.is_str) {
-    output = std::string{sub_view};
-  } else {
-    List list;
-    while (const auto next = decode_impl(sub_view)) {
-      list.push_back(std::move(*next));
-    }
-    output = list;
+  if (!is_list && len == 1 && static_cast<unsigned char>(in_[0]) <= 0x7f) {
+    throw std::invalid_argument("single byte with a prefix");
   }
 
-  input.remove_prefix(x.data_len);
-  return output;
+  const auto payload = in_.substr(0, len);
+  in_.remove_prefix(len);
+  return payload;
 }
 
-}  // namespace
+std::string_view Reader::read_string() {
+  bool is_list;
+  const auto payload = read(is_list);
+  if (is_list) {
+    throw std::invalid_argument("string expected");
+  }
+  return payload;
+}
 
-namespace silkworm::rlp {
+Reader Reader::read_list() {
+  bool is_list;
+  const auto payload = read(is_list);
+  if (!is_list) {
+    throw std::invalid_argument("list expected");
+  }
+  return Reader(payload);
+}
 
-void encode(const Item& in, std::string& out) {
-  boost::apply_visitor(Encoder(out), in);
+uint64_t Reader::read_uint64() {
+  const auto b = read_string();
+  if (b.size() > 8) {
+    throw std::invalid_argument("scalar too big");
+  }
+  if (!b.empty() && b[0] == '\0') {
+    throw std::invalid_argument("scalar with leading zeroes");
+  }
+  return from_big_endian(b);
 }
 
-Item decode(std::string_view input) {
-  const auto output = decode_impl(input);
-  if (!output) {
-    throw std::invalid_argument("input is null");
+UInt256 Reader::read_uint256() {
+  const auto b = read_string();
+  if (b.size() > 32) {
+    throw std::invalid_argument("scalar too big");
   }
-  if (!input.empty()) {
-    throw std::invalid_argument("extra input");
+  if (!b.empty() && b[0] == '\0') {
+    throw std::invalid_argument("scalar with leading zeroes");
   }
-  return *output;
+  return uint256_from_big_endian(b);
+}
+
+void Reader::skip() {
+  bool is_list;
+  read(is_list);
 }
 
 std::string to_big_endian(uint64_t x) {
-  if (x == 0)
-    return "";
-  else
-    return to_big_endian(x / 256) + static_cast<char>(x % 256);
+  char buf[8];
+  return std::string(buf, to_big_endian(x, buf) - buf);
 }
 
 std::string to_big_endian(UInt256 x) {
-  std::string out;
-  export_bits(x, std::back_inserter(out), 8);
-  return out;
+  char buf[32];
+  return std::string(buf, to_big_endian(x, buf) - buf);
+}
+
+size_t big_endian_length(uint64_t x) {
+  return 8 - count_leading_zeros(x) / 8;
+}
+
+size_t big_endian_length(const UInt256& x) { return (x.bit_length() + 7) / 8; }
+
+char* to_big_endian(uint64_t x, char* out) {
+  char buf[8];
+  store_big_endian(x, buf);
+  const auto len = big_endian_length(x);
+  std::memcpy(out, buf + 8 - len, len);
+  return out + len;
+}
+
+char* to_big_endian(const UInt256& x, char* out) {
+  char buf[32];
+  for (unsigned i = 0; i < 4; ++i) {
+    store_big_endian(x.word(3 - i), buf + 8 * i);
+  }
+  const auto len = big_endian_length(x);
+  std::memcpy(out, buf + 32 - len, len);
+  return out + len;
 }
 
 uint64_t from_big_endian(std::string_view b) {
@@ -224,6 +321,19 @@ uint64_t from_big_endian(std::string_view b) {
   return res;
 }
 
+UInt256 uint256_from_big_endian(std::string_view b) {
+  if (b.size() > 32) {
+    throw std::invalid_argument("scalar too big");
+  }
+  char buf[32] = {};
+  std::memcpy(buf + 32 - b.size(), b.data(), b.size());
+  UInt256 res;
+  for (unsigned i = 0; i < 4; ++i) {
+    res.set_word(3 - i, load_big_endian(buf + 8 * i));
+  }
+  return res;
+}
+
 bool are_equal(const Item& lhs, const Item& rhs) {
   return boost::apply_visitor(Comparator(), lhs, rhs);
 }
@@ -38,6 +38,7 @@ using List = std::vector<Item>;
 // TODO: submit a bugreport to boost
 bool are_equal(const Item&, const Item&);
 
+// appends to out
 void encode(const Item&, std::string& out);
 
 inline std::string encode(const Item& item) {
@@ -46,13 +47,65 @@ inline std::string encode(const Item& item) {
   return out;
 }
 
+// exact size of encode(item)
+size_t encoded_length(const Item&);
+
+// Writes encode(item) to out, which must have room for
+// encoded_length(item) bytes. Returns the end of the output.
+char* encode_into(const Item&, char* out);
+
+// Building blocks for encoding without Items, allocation-free.
+// The encode_ functions write to out and return the end of the output.
+size_t string_encoded_length(std::string_view);
+size_t list_encoded_length(size_t payload_length);
+
+char* encode_string(std::string_view, char* out);
+char* encode_list_header(size_t payload_length, char* out);
+
 Item decode(std::string_view);
 
+// Walks an encoding without copying or allocating; the views returned
+// point into the input. Throws std::invalid_argument on malformed or
+// non-canonical input.
+class Reader {
+ public:
+  explicit Reader(std::string_view in) : in_{in} {}
+
+  bool empty() const { return in_.empty(); }
+
+  bool next_is_list() const;
+
+  std::string_view read_string();
+
+  // a reader over the items of the next list
+  Reader read_list();
+
+  // scalars may not have leading zeroes
+  uint64_t read_uint64();
+  UInt256 read_uint256();
+
+  void skip();
+
+ private:
+  std::string_view in_;
+
+  // payload of the next item, which is consumed
+  std::string_view read(bool& is_list);
+};
+
+// without leading zeroes, so zero is empty
 std::string to_big_endian(uint64_t);
 std::string to_big_endian(UInt256);
 
-// TODO UInt256
+size_t big_endian_length(uint64_t);
+size_t big_endian_length(const UInt256&);
+
+// write at most 8 and 32 bytes respectively
+char* to_big_endian(uint64_t, char* out);
+char* to_big_endian(const UInt256&, char* out);
+
 uint64_t from_big_endian(std::string_view b);
+UInt256 uint256_from_big_endian(std::string_view b);
 }  // namespace silkworm::rlp
 
 #endif  // SILKWORM_CORE_RLP_HPP_
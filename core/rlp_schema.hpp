@@ -0,0 +1,266 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_RLP_SCHEMA_HPP_
+#define SILKWORM_CORE_RLP_SCHEMA_HPP_
+
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "rlp.hpp"
+
+// RLP encoding of fixed structures, resolved at compile time rather than
+// going through Items. Each Codec<T> provides
+//   static size_t length(const T&);           // exact encoded size
+//   static char* encode(const T&, char* out); // returns the end
+//   static void decode(Reader&, T&);
+// and Schema describes a struct as the list of some of its members:
+//   template <>
+//   struct Codec<Account> : Schema<Account, &Account::nonce, ...> {};
+
+namespace silkworm::rlp {
+
+template <class T, class = void>
+struct Codec;
+
+template <class T>
+struct Codec<T, std::enable_if_t<std::is_unsigned_v<T>>> {
+  static size_t length(T x) {
+    return x != 0 && x < 0x80 ? 1 : 1 + big_endian_length(x);
+  }
+
+  static char* encode(T x, char* out) {
+    char buf[8];
+    const auto end = to_big_endian(static_cast<uint64_t>(x), buf);
+    return encode_string({buf, static_cast<size_t>(end - buf)}, out);
+  }
+
+  static void decode(Reader& in, T& x) {
+    const auto val = in.read_uint64();
+    if (val > std::numeric_limits<T>::max()) {
+      throw std::invalid_argument("scalar too big");
+    }
+    x = static_cast<T>(val);
+  }
+};
+
+template <class T>
+struct Codec<T, std::enable_if_t<std::is_enum_v<T>>> {
+  using Underlying = Codec<std::make_unsigned_t<std::underlying_type_t<T>>>;
+
+  static size_t length(T x) { return Underlying::length(to_underlying(x)); }
+
+  static char* encode(T x, char* out) {
+    return Underlying::encode(to_underlying(x), out);
+  }
+
+  static void decode(Reader& in, T& x) {
+    std::make_unsigned_t<std::underlying_type_t<T>> val;
+    Underlying::decode(in, val);
+    x = static_cast<T>(val);
+  }
+
+ private:
+  static auto to_underlying(T x) {
+    return static_cast<std::make_unsigned_t<std::underlying_type_t<T>>>(x);
+  }
+};
+
+template <>
+struct Codec<UInt256> {
+  static size_t length(const UInt256& x) {
+    return x != 0 && x < 0x80 ? 1 : 1 + big_endian_length(x);
+  }
+
+  static char* encode(const UInt256& x, char* out) {
+    char buf[32];
+    const auto end = to_big_endian(x, buf);
+    return encode_string({buf, static_cast<size_t>(end - buf)}, out);
+  }
+
+  static void decode(Reader& in, UInt256& x) { x = in.read_uint256(); }
+};
+
+template <>
+struct Codec<Hash> {
+  static constexpr size_t length(const Hash&) { return 1 + kHashBytes; }
+
+  static char* encode(const Hash& x, char* out) {
+    return encode_string(byte_view(x), out);
+  }
+
+  static void decode(Reader& in, Hash& x) {
+    x = string_to_hash(in.read_string());
+  }
+};
+
+template <>
+struct Codec<std::string> {
+  static size_t length(const std::string& x) {
+    return string_encoded_length(x);
+  }
+
+  static char* encode(const std::string& x, char* out) {
+    return encode_string(x, out);
+  }
+
+  static void decode(Reader& in, std::string& x) { x = in.read_string(); }
+};
+
+// a list of no items or one
+template <class T>
+struct Codec<std::optional<T>> {
+  static size_t length(const std::optional<T>& x) {
+    return list_encoded_length(x ? Codec<T>::length(*x) : 0);
+  }
+
+  static char* encode(const std::optional<T>& x, char* out) {
+    if (!x) {
+      return encode_list_header(0, out);
+    }
+    out = encode_list_header(Codec<T>::length(*x), out);
+    return Codec<T>::encode(*x, out);
+  }
+
+  static void decode(Reader& in, std::optional<T>& x) {
+    auto items = in.read_list();
+    if (items.empty()) {
+      x.reset();
+      return;
+    }
+    Codec<T>::decode(items, x.emplace());
+    if (!items.empty()) {
+      throw std::invalid_argument("optional with more than one item");
+    }
+  }
+};
+
+template <class T>
+struct Codec<std::vector<T>> {
+  static size_t length(const std::vector<T>& x) {
+    return list_encoded_length(payload_length(x));
+  }
+
+  static char* encode(const std::vector<T>& x, char* out) {
+    out = encode_list_header(payload_length(x), out);
+    for (const auto& item : x) {
+      out = Codec<T>::encode(item, out);
+    }
+    return out;
+  }
+
+  static void decode(Reader& in, std::vector<T>& x) {
+    auto items = in.read_list();
+    x.clear();
+    while (!items.empty()) {
+      Codec<T>::decode(items, x.emplace_back());
+    }
+  }
+
+ private:
+  static size_t payload_length(const std::vector<T>& x) {
+    size_t len = 0;
+    for (const auto& item : x) {
+      len += Codec<T>::length(item);
+    }
+    return len;
+  }
+};
+
+template <class A, class B>
+struct Codec<std::pair<A, B>> {
+  static size_t length(const std::pair<A, B>& x) {
+    return list_encoded_length(payload_length(x));
+  }
+
+  static char* encode(const std::pair<A, B>& x, char* out) {
+    out = encode_list_header(payload_length(x), out);
+    out = Codec<A>::encode(x.first, out);
+    return Codec<B>::encode(x.second, out);
+  }
+
+  static void decode(Reader& in, std::pair<A, B>& x) {
+    auto items = in.read_list();
+    Codec<A>::decode(items, x.first);
+    Codec<B>::decode(items, x.second);
+    if (!items.empty()) {
+      throw std::invalid_argument("pair with more than two items");
+    }
+  }
+
+ private:
+  static size_t payload_length(const std::pair<A, B>& x) {
+    return Codec<A>::length(x.first) + Codec<B>::length(x.second);
+  }
+};
+
+template <class T, class M>
+M member_type(M T::*);
+
+// T as the list of the given members, in order
+template <class T, auto... kMembers>
+struct Schema {
+  static size_t length(const T& x) {
+    return list_encoded_length(payload_length(x));
+  }
+
+  static char* encode(const T& x, char* out) {
+    out = encode_list_header(payload_length(x), out);
+    ((out = Codec<decltype(member_type(kMembers))>::encode(x.*kMembers, out)),
+     ...);
+    return out;
+  }
+
+  static std::string encode(const T& x) {
+    std::string out(length(x), '\0');
+    encode(x, &out[0]);
+    return out;
+  }
+
+  static void decode(Reader& in, T& x) {
+    auto items = in.read_list();
+    (Codec<decltype(member_type(kMembers))>::decode(items, x.*kMembers), ...);
+    if (!items.empty()) {
+      throw std::invalid_argument("too many items");
+    }
+  }
+
+  // throws std::invalid_argument on extra input
+  static void decode(std::string_view in, T& x) {
+    Reader reader(in);
+    decode(reader, x);
+    if (!reader.empty()) {
+      throw std::invalid_argument("extra input");
+    }
+  }
+
+ private:
+  static size_t payload_length(const T& x) {
+    return (Codec<decltype(member_type(kMembers))>::length(x.*kMembers) + ...
+            + 0);
+  }
+};
+
+}  // namespace silkworm::rlp
+
+#endif  // SILKWORM_CORE_RLP_SCHEMA_HPP_
@@ -23,15 +23,20 @@
 #include "keccak.hpp"
 #include "mptrie.hpp"
 #include "rlp.hpp"
+#include "verifier.hpp"
 
 namespace silkworm {
 
 // TODO randomize phase 1 & 2 cursors
 State::State(DbBucket& db, uint8_t depth, uint8_t phase1_depth)
     : db_(db),
-      tree_(depth),
+      hash_depth_(depth),
       phase1_cursor_(phase1_depth),
       phase2_leaf_cursor_(depth) {
+  reset_tree(depth, phase1_depth);
+}
+
+void State::reset_tree(uint8_t depth, uint8_t phase1_depth) {
   if (depth < 2) {
     throw std::length_error("too shallow");
   }
@@ -43,18 +48,94 @@ State::State(DbBucket& db, uint8_t depth, uint8_t phase1_depth)
     throw std::invalid_argument("phase1_depth > depth");
   }
 
+  tree_.clear();
+  tree_.resize(depth);
   for (uint8_t i = 0; i < depth; ++i) {
     tree_[i].resize(1ull << (i * 4));
   }
+  hash_depth_ = depth;
+  node_cache_.reset();
+  if (reply_cache_) {
+    reply_cache_->clear();
+  }
+
+  stale_.clear();
+  for (uint8_t i = 0; i < depth; ++i) {
+    stale_.emplace_back(1ull << (i * 4), true);
+  }
+  unsynced_ = HierarchicalBitmap(1ull << (depth * 4), true);
+
+  phase1_cursor_ = Prefix(phase1_depth);
+  phase2_leaf_cursor_ = Prefix(depth);
+  phase2_node_cursor_ = Prefix(1);
 }
 
 void State::init_from_db(const uint32_t data_valid_for_block) {
+  if (journal_) {
+    journal_->seal(data_valid_for_block);
+  }
+  save_history(data_valid_for_block);
+  rehash_from_db(data_valid_for_block);
+}
+
+void State::restructure(uint8_t depth, uint8_t phase1_depth) {
+  history_.clear();
+  history_head_ = -1;
+
+  reset_tree(depth, phase1_depth);
+  rehash_from_db(-1);
+
+  // start phase 2 from the root since no node is tied to a block anymore
+  phase2_node_cursor_ = Prefix(0);
+}
+
+void State::set_phase1_depth(uint8_t phase1_depth) {
+  if (phase1_depth > depth()) {
+    throw std::invalid_argument("phase1_depth > depth");
+  }
+  if (phase1_depth == 0) {
+    phase1_cursor_ = Prefix(0);
+    return;
+  }
+  const auto shift = 64 - 4 * phase1_depth;
+  phase1_cursor_ =
+      Prefix(phase1_depth, phase1_cursor_.val() >> shift << shift);
+}
+
+void State::hash_deeper(uint8_t hash_depth, size_t max_nodes) {
+  if (hash_depth < depth()) {
+    throw std::invalid_argument("hash_depth < depth");
+  }
+  if (hash_depth > 15) {
+    throw std::length_error("too deep");
+  }
+
+  hash_depth_ = hash_depth;
+  node_cache_.emplace(max_nodes);
+  if (reply_cache_) {
+    reply_cache_->clear();
+  }
+  // of the old depth
+  history_.clear();
+
+  const auto block = synced_block();
+  if (block >= 0) {
+    for (auto& nodes : tree_) {
+      for (auto& nd : nodes) {
+        nd.synced.reset();
+      }
+    }
+    rehash_from_db(block);
+  }
+}
+
+void State::rehash_from_db(const int32_t block) {
   auto prefix = Prefix(depth());
 
   // bottom nodes
   for (uint64_t i = 0; i < tree_.back().size(); ++i) {
     auto& nodes = tree_.back();
-    nodes[i].block = data_valid_for_block;
+    nodes[i].block = block;
 
     if (nodes[i].synced.all()) {
       prefix += 16;
@@ -66,16 +147,25 @@ void State::init_from_db(const uint32_t data_valid_for_block) {
         continue;
       }
 
-      const auto hasher = db_util::hasher(db_, prefix);
+      if (hash_depth_ > depth()) {
+        const auto below = deep_node(prefix);
+        nodes[i].empty[j] = below.empty.all();
+        if (!below.empty.all()) {
+          nodes[i].hash[j] = mptrie::branch_node_hash(below.empty, below.hash);
+        }
+      } else {
+        const auto hasher = db_util::hasher(db_, prefix);
 
-      nodes[i].empty[j] = hasher.empty();
+        nodes[i].empty[j] = hasher.empty();
 
-      if (!hasher.empty()) {
-        nodes[i].hash[j] = hasher.hash();
+        if (!hasher.empty()) {
+          nodes[i].hash[j] = hasher.hash();
+        }
       }
 
       nodes[i].synced[j] = true;
     }
+    nodes[i].dirty = true;
   }
 
   // the rest of the tree
@@ -83,7 +173,7 @@ void State::init_from_db(const uint32_t data_valid_for_block) {
     auto& nodes = tree_[lvl];
 
     for (uint64_t i = 0; i < nodes.size(); ++i) {
-      nodes[i].block = data_valid_for_block;
+      nodes[i].block = block;
 
       if (nodes[i].synced.all()) {
         continue;
@@ -98,16 +188,142 @@ void State::init_from_db(const uint32_t data_valid_for_block) {
         const bool empty = child.empty.all();
         nodes[i].empty[j] = empty;
         if (!empty) {
-          nodes[i].hash[j] = mptrie::branch_node_hash(child.empty, child.hash);
+          nodes[i].hash[j] = branch_hash(child);
         }
         nodes[i].synced[j] = true;
       }
+      nodes[i].dirty = true;
     }
   }
 }
 
+const Hash& State::branch_hash(const Node& nd) {
+  if (nd.dirty) {
+    nd.own_hash = mptrie::branch_node_hash(nd.empty, nd.hash);
+    nd.dirty = false;
+  }
+  return nd.own_hash;
+}
+
+Hash State::root_hash() const { return branch_hash(root()); }
+
+Hash State::root_hash(uint8_t depth, const std::vector<sync::Leaf>& leaves) {
+  return sync::subtree_hash(0, depth, leaves, sync::hash_leaves(leaves));
+}
+
 void State::put(Hash key, std::string val) {
+  if (journal_) {
+    journal_->record(db_, byte_view(key));
+  }
+  invalidate_path(key);
+  db_.put(byte_view(key), val);
+}
+
+void State::del(Hash key) {
+  if (journal_) {
+    journal_->record(db_, byte_view(key));
+  }
+  invalidate_path(key);
+  const auto k = byte_view(key);
+  db_.del(k, std::string(k) + '\0');
+}
+
+void State::keep_undo_journal(uint32_t max_blocks) {
+  journal_.emplace(max_blocks);
+  if (synced_block() >= 0) {
+    journal_->seal(synced_block());
+  }
+}
+
+void State::unwind(uint32_t block) {
+  if (!journal_) {
+    throw std::logic_error("no undo journal");
+  }
+
+  for (const auto& key : journal_->unwind(db_, block)) {
+    invalidate_path(string_to_hash(key));
+  }
+  rehash_from_db(block);
+
+  while (!history_.empty() &&
+         history_.back().block >= static_cast<int32_t>(block)) {
+    history_.pop_back();
+  }
+  if (history_blocks_) {
+    history_head_ = block;
+  }
+}
+
+void State::keep_history(uint32_t num_blocks) {
+  history_blocks_ = num_blocks;
+  history_head_ = synced_block();
+}
+
+void State::save_history(const int32_t new_block) {
+  if (!history_blocks_) {
+    return;
+  }
+
+  if (history_head_ < 0 || new_block != history_head_ + 1) {
+    // can't tell what the nodes looked like in between
+    history_.clear();
+    history_head_ = new_block;
+    return;
+  }
+
+  // only the nodes about to be rehashed change
+  Version version{history_head_, {}};
+  version.nodes.resize(depth());
+  for (uint8_t level = 0; level < depth(); ++level) {
+    const auto& nodes = tree_[level];
+    for (uint64_t i = 0; i < nodes.size(); ++i) {
+      if (!nodes[i].synced.all()) {
+        version.nodes[level].emplace(i, nodes[i]);
+      }
+    }
+  }
+  history_.push_back(std::move(version));
+
+  while (history_.size() > history_blocks_) {
+    history_.pop_front();
+  }
+  history_head_ = new_block;
+}
+
+bool State::has_history(const int32_t block) const {
+  if (history_.empty() || block < history_.front().block ||
+      block >= history_head_ || synced_block() != history_head_) {
+    return false;
+  }
+  const auto earliest = journal_ ? journal_->earliest_block() : std::nullopt;
+  return earliest && static_cast<int32_t>(*earliest) <= block;
+}
+
+const State::Node& State::node_at(const uint8_t level, const Prefix prefix,
+                                  const int32_t block) const {
+  const auto index = node_index(level, prefix);
+  // the first change after the block has the node as of the block
+  for (const auto& version : history_) {
+    if (version.block < block) {
+      continue;
+    }
+    const auto& nodes = version.nodes[level];
+    const auto it = nodes.find(index);
+    if (it != nodes.end()) {
+      return it->second;
+    }
+  }
+  return tree_[level][index];
+}
+
+void State::invalidate_path(const Hash& key) {
   root().block = -1;  // prevent sync while block is not sealed yet
+  if (reply_cache_) {
+    reply_cache_->invalidate(key);
+  }
+  if (node_cache_) {
+    node_cache_->invalidate(key);
+  }
 
   const Prefix prefix(depth(), key);
   for (uint8_t level = 0; level < depth(); ++level) {
@@ -115,8 +331,31 @@ void State::put(Hash key, std::string val) {
     const Nibble nbl = prefix[level];
     nd.synced[nbl] = false;
   }
+  mark_unsynced(depth() - 1, prefix, prefix.last());
+}
 
-  db_.put(byte_view(key), val);
+void State::mark_unsynced(const uint8_t level, const Prefix prefix,
+                          const Nibble nibble) {
+  const auto tail = 4 * (depth() - 1 - level);
+  const auto begin = (node_index(level, prefix) * 16 + nibble) << tail;
+  unsynced_.set(begin, begin + (1ull << tail));
+}
+
+void State::mark_stale(const uint8_t level, const Prefix prefix,
+                       const Nibble nibble) {
+  if (level + 1 >= depth()) {
+    return;
+  }
+  auto child = Prefix(level + 1, prefix.val());
+  child.set(level, nibble);
+  stale_[level + 1].set(node_index(level, prefix) * 16 + nibble);
+
+  // rewind the walk if it's past the child already
+  auto& cursor = phase2_node_cursor_;
+  if (cursor.size() > child.size() ||
+      (cursor.size() == child.size() && cursor.val() > child.val())) {
+    cursor = child;
+  }
 }
 
 void State::update_blocks_down_path(Prefix prefix) {
@@ -140,7 +379,7 @@ bool State::update_block_at(const Prefix prefix, const uint8_t level) {
   }
 
   const bool child_empty = child.empty.all();
-  const Hash child_hash = mptrie::branch_node_hash(child.empty, child.hash);
+  const Hash& child_hash = branch_hash(child);
 
   const auto nibble = prefix[level - 1];
   if (nibble_obsolete(parent, nibble, child_empty, child_hash)) {
@@ -148,6 +387,9 @@ bool State::update_block_at(const Prefix prefix, const uint8_t level) {
   }
 
   child.block = parent.block;
+  // The child may have caught up with the block before the parent did,
+  // e.g. from leaves of a newer block, so a synced child syncs the parent.
+  propagate_synced_up(prefix, level);
   return true;
 }
 
@@ -168,27 +410,36 @@ sync::LeavesReply State::get_leaves(
   if (prefix.size() == 0) {
     throw std::runtime_error("TODO prefix.size = 0 not implemented yet");
   }
-  if (prefix.size() > depth()) {
+  if (prefix.size() > hash_depth_) {
     throw std::runtime_error("TODO prefix.size > depth not implemented yet");
   }
 
+  // deeper prefixes are served at the newest block only
+  const bool deep = prefix.size() > depth();
+
+  auto rb =
+      request.block_number ? static_cast<int32_t>(*request.block_number) : -1;
+  if (rb >= 0 && !deep && has_history(rb)) {
+    return get_leaves_at(request, rb);
+  }
+
   sync::LeavesReply reply;
+  reply.head_block = std::max(root().block, 0);
 
-  if (consistent_path_depth(prefix) != prefix.size()) {
+  // the part of the path in the tree
+  const Prefix path(std::min(prefix.size(), depth()), prefix.padded());
+  if (consistent_path_depth(path) != path.size()) {
     reply.status = sync::LeavesReply::kDontHaveData;
     return reply;
   }
 
-  const Node& nd = node(prefix.size() - 1, prefix);
-  const auto nibble = prefix.last();
+  const Node& nd = node(path.size() - 1, path);
 
-  if (!nd.synced[nibble]) {
+  if (!nd.synced[path.last()]) {
     reply.status = sync::LeavesReply::kDontHaveData;
     return reply;
   }
 
-  auto rb =
-      request.block_number ? static_cast<int32_t>(*request.block_number) : -1;
   if (rb > nd.block) {
     reply.status = sync::LeavesReply::kDontHaveData;
     return reply;
@@ -199,24 +450,111 @@ sync::LeavesReply State::get_leaves(
   const bool full_proof = rb < nd.block;
   const uint8_t proof_start = full_proof ? 0 : request.from_level;
 
+  const ReplyCache::Key key{prefix, proof_start, request.hash};
+  if (reply_cache_) {
+    if (const auto cached = reply_cache_->find(key)) {
+      reply = *cached;
+      reply.block_number = nd.block;
+      reply.head_block = std::max(root().block, 0);
+      return reply;
+    }
+  }
+
   for (auto i = proof_start; i < prefix.size(); ++i) {
-    const auto& y = node(i, prefix);
-    reply.proof.push_back(sync::Proof{y.empty, y.hash});
+    reply.proof.push_back(node_on_path(i, prefix));
   }
 
-  reply.leaves = std::vector<sync::Leaf>{};
-  if (!nd.empty[nibble]) {
+  const auto parent = proof_start < prefix.size()
+                          ? reply.proof.back()
+                          : node_on_path(prefix.size() - 1, prefix);
+  const auto nibble = prefix.last();
+
+  if (request.hash && !parent.empty[nibble] &&
+      parent.hash[nibble] == *request.hash) {
+    // not cached: as cheap to recompute as to copy
+    return reply;
+  }
+
+  reply.leaves.emplace();
+  if (!parent.empty[nibble]) {
+    // views into the bucket rather than copies if it can keep them valid
+    reply.leaves.emplace(db_.pin());
     db_util::iterate(
         db_, prefix, [&reply](std::string_view key, std::string_view val) {
-          reply.leaves->push_back(sync::Leaf{string_to_hash(key), val});
+          reply.leaves->push_back(string_to_hash(key), val);
         });
   }
 
+  if (reply_cache_) {
+    auto copy = reply;
+    copy.leaves->unpin();
+    reply_cache_->insert(key, std::move(copy));
+  }
+
   return reply;
 }
 
-std::variant<std::monostate, sync::GetLeavesRequest, sync::GetNodeRequest>
-State::next_sync_request() {
+sync::LeavesReply State::get_leaves_at(const sync::GetLeavesRequest& request,
+                                       const int32_t block) const {
+  const auto prefix = request.prefix;
+
+  sync::LeavesReply reply;
+  reply.head_block = root().block;
+  reply.block_number = block;
+
+  for (auto i = request.from_level; i < prefix.size(); ++i) {
+    const auto& y = node_at(i, prefix, block);
+    reply.proof.push_back(sync::Proof{y.empty, y.hash});
+  }
+
+  const auto& nd = node_at(prefix.size() - 1, prefix, block);
+  const auto nibble = prefix.last();
+  if (request.hash && !nd.empty[nibble] && nd.hash[nibble] == *request.hash) {
+    return reply;
+  }
+
+  reply.leaves.emplace();
+  if (nd.empty[nibble]) {
+    return reply;
+  }
+
+  // merge the current leaves with their old values
+  const auto range = prefix.string_range();
+  const auto changes =
+      journal_->changes_since(block, range.first, range.second);
+  auto change = changes.begin();
+  auto& leaves = *reply.leaves;
+
+  const auto add_old_until = [&](std::optional<std::string_view> key) {
+    for (; change != changes.end() && (!key || change->first < *key);
+         ++change) {
+      if (change->second) {
+        leaves.push_back(string_to_hash(change->first), *change->second);
+      }
+    }
+  };
+
+  db_util::iterate(db_, prefix, [&](std::string_view key,
+                                    std::string_view val) {
+    add_old_until(key);
+    if (change != changes.end() && change->first == key) {
+      if (change->second) {
+        leaves.push_back(string_to_hash(key), *change->second);
+      }
+      ++change;
+    } else {
+      leaves.push_back(string_to_hash(key), val);
+    }
+  });
+  add_old_until({});
+
+  return reply;
+}
+
+sync::Request State::next_sync_request() {
+  sync::Profiler::Scope scope(profiler_, sync::Profiler::kNextRequest,
+                              sync_phase());
+
   if (!phase1_sync_done_) {
     const auto r = next_leaves_request(phase1_cursor_, true);
     if (!r)
@@ -225,7 +563,8 @@ State::next_sync_request() {
       return *r;
   }
 
-  if (synced_block() == -1) {
+  // the root is refetched even if synced once it's known to be stale
+  if (synced_block() == -1 || phase2_node_cursor_.size() == 0) {
     const auto nr = next_node_request();
     if (!nr.prefixes.empty()) {
       return nr;
@@ -257,12 +596,23 @@ sync::GetNodeRequest State::next_node_request() {
     return request;
   }
 
+  auto& stale = stale_[level];
+  const auto shift = 64 - 4 * level;
   while (true) {
-    update_block_at(prefix, level);
+    const auto i = stale.find_next(prefix.val() >> shift);
+    if (i == stale.size()) {
+      prefix = Prefix(level + 1);
+      return request;
+    }
+    prefix = Prefix(level, i << shift);
 
-    const auto& nd = node(level, prefix);
-    if (nd.block < root().block) {
+    // nodes off the stale paths catch up lazily
+    update_blocks_down_path(Prefix(level + 1, prefix.val()));
+
+    if (node(level, prefix).block < root().block) {
       request.prefixes.push_back(prefix);
+    } else {
+      stale.reset(i);
     }
 
     ++prefix;
@@ -280,7 +630,17 @@ sync::GetNodeRequest State::next_node_request() {
 
 std::optional<sync::GetLeavesRequest> State::next_leaves_request(Prefix& cursor,
                                                                  bool phase1) {
+  const auto shift = 64 - 4 * depth();
   do {
+    if (!phase1) {
+      const auto next = unsynced_.find_next(cursor.val() >> shift);
+      if (next == unsynced_.size()) {
+        cursor = Prefix(depth());
+        return {};
+      }
+      cursor = Prefix(depth(), next << shift);
+    }
+
     const auto prefix = cursor;
     ++cursor;
 
@@ -291,14 +651,34 @@ std::optional<sync::GetLeavesRequest> State::next_leaves_request(Prefix& cursor,
     const auto cpd = consistent_path_depth(prefix);
 
     if (nd.synced[x] && (cpd == prefix.size() || phase1)) {
+      if (!phase1) {
+        // A synced nibble vouches for its whole subtree, so skip the
+        // largest one containing the prefix.
+        uint8_t level = 0;
+        while (!node(level, prefix).synced[prefix[level]]) {
+          ++level;
+        }
+        const auto tail = 4 * (depth() - 1 - level);
+        const auto begin = (prefix.val() >> shift) >> tail << tail;
+        const auto end = begin + (1ull << tail);
+        unsynced_.reset(begin, end);
+        cursor = Prefix(depth(), end << shift);
+      }
       continue;
     } else {
       sync::GetLeavesRequest request{prefix};
 
-      if (root().block != -1) {
+      // Phase 1 leaves are wanted as new as possible rather than
+      // at a block the seeder might still have in its history.
+      if (root().block != -1 && !phase1) {
         request.block_number = root().block;
       }
 
+      // Synced but off the root's path, the leaves may well be current.
+      if (nd.synced[x] && !nd.empty[x]) {
+        request.hash = nd.hash[x];
+      }
+
       request.from_level = cpd;
       return request;
     }
@@ -315,30 +695,62 @@ bool State::nibble_obsolete(const Node& node, const Nibble nibble,
     return node.empty[nibble] != new_empty;
 }
 
-void State::process_leaves_reply(const Prefix prefix,
-                                 const sync::LeavesReply& reply) {
+void State::track_changed_keys() {
+  if (!changed_keys_) {
+    changed_keys_.emplace();
+  }
+}
+
+std::set<Hash> State::take_changed_keys() {
+  std::set<Hash> keys;
+  if (changed_keys_) {
+    keys.swap(*changed_keys_);
+  }
+  return keys;
+}
+
+void State::replace_leaves(const Prefix prefix, const sync::LeafBatch& leaves) {
+  if (!changed_keys_) {
+    db_util::replace(db_, prefix, leaves);
+    return;
+  }
+  db_util::replace(db_, prefix, leaves, [this](std::string_view key) {
+    changed_keys_->insert(string_to_hash(key));
+  });
+}
+
+bool State::process_leaves_reply(const Prefix prefix,
+                                 const sync::LeavesReply& reply,
+                                 const sync::Verdict* verdict) {
   if (prefix.size() == 0) {
     throw std::runtime_error("TODO prefix.size = 0 not implemented yet");
   }
   if (prefix.size() > depth()) {
     throw std::runtime_error("TODO prefix.size > depth not implemented yet");
   }
+  if (hash_depth_ != depth()) {
+    throw std::logic_error("can't sync a tree hashed deeper than kept");
+  }
+
+  const auto phase = sync_phase();
+  sync::Profiler::Scope scope(profiler_, sync::Profiler::kLeavesReply, phase);
 
   auto& main_node = node(prefix.size() - 1, prefix);
 
   int32_t rb = reply.block_number;
   if (root().block > rb) {
-    return;  // old reply
-  } else if (root().block < rb) {
+    return true;  // old reply
+  }
+  if (verdict && !proof_fits(prefix, reply, *verdict)) {
+    // Most likely the tree is of a fork the peer has since abandoned
+    // for one with the same block number; start over from its root.
+    resume_sync();
+    return false;
+  }
+  if (root().block < rb) {
     phase2_node_cursor_ = Prefix(1);
   }
 
-  // TODO verify the reply (proof hashes, etc)
-  // if !reply.leaves, check that's legit
-  // otherwise check leaves match the prefix
-  // and their hash matches proof
-  // and they are strictly ordered
-
   const auto tail = depth() - prefix.size();
 
   if (tail == 0) {  // prefix.size() == depth()
@@ -355,66 +767,66 @@ void State::process_leaves_reply(const Prefix prefix,
 
       if (j == nibble) {
         if (reply.leaves) {
-          if (main_node.synced[j] && !main_node.empty[j]) {
-            db_util::del(db_, nibble_prefix);
-          }
-
-          auto it = reply.leaves->begin();
-          const auto end = reply.leaves->end();
-
-          db_.put([&it, end]() -> std::optional<DbBucket::KeyVal> {
-            if (it == end) {
-              return {};
-            }
-            DbBucket::KeyVal x(byte_view(it->first), it->second);
-            ++it;
-            return x;
-          });
+          sync::Profiler::Scope db_write(profiler_, sync::Profiler::kDbWrite,
+                                         phase);
+
+          // even if not synced: leaves deleted since, e.g. by a reorg,
+          // might still be there
+          replace_leaves(nibble_prefix, *reply.leaves);
         }
         main_node.empty[j] = new_empty[j];
         main_node.hash[j] = new_hash[j];
+        main_node.dirty = true;
         main_node.synced[j] = true;
       } else if (nibble_obsolete(main_node, j, new_empty[j], new_hash[j])) {
-        if (main_node.synced[j] && !main_node.empty[j]) {
-          db_util::del(db_, nibble_prefix);
-        }
+        // its leaves stay until refetched, when most are still current
         main_node.synced[j] = false;
+        mark_unsynced(prefix.size() - 1, prefix, j);
       }
     }
   } else if (reply.leaves) {  // prefix.size() < depth()
-    auto it = reply.leaves->begin();
+    {
+      sync::Profiler::Scope db_write(profiler_, sync::Profiler::kDbWrite,
+                                     phase);
+      replace_leaves(prefix, *reply.leaves);
+    }
 
-    db_util::del(db_, prefix);
+    sync::Profiler::Scope hashing(profiler_, sync::Profiler::kHashing, phase);
 
-    // process bottom nodes
+    const auto& leaves = *reply.leaves;
+    std::vector<Hash> own_hashes;
+    if (!verdict) {
+      own_hashes = sync::hash_leaves(leaves);
+    }
+    const auto& leaf_hashes = verdict ? verdict->leaf_hashes : own_hashes;
+
+    // process bottom nodes, partitioning the sorted leaves among them
+    // by the index of their bottom prefix
+    const auto shift = 64 - 4 * depth();
+    const auto bottom_index = [&leaves, shift](size_t i) {
+      return Prefix(16, leaves[i].first).val() >> shift;
+    };
     auto btm_prfx = Prefix{depth(), prefix.val()};
+    size_t j = 0;
 
     for (uint64_t i = 0; i < (1ull << (4 * tail)); ++i, ++btm_prfx) {
       const auto nibble = btm_prfx.last();
       auto& bottom_node = node(depth() - 1, btm_prfx);
+      const auto index = btm_prfx.val() >> shift;
 
       LeafHasher hasher;
 
-      auto it2 = it;
-      for (; it != reply.leaves->end() && btm_prfx.matches(it->first); ++it) {
-        hasher.append(byte_view(it->first), it->second);
+      for (; j < leaves.size() && bottom_index(j) == index; ++j) {
+        hasher.append_hash(leaf_hashes[j]);
       }
 
-      db_.put([&it2, it]() -> std::optional<DbBucket::KeyVal> {
-        if (it2 == it) {
-          return {};
-        }
-        DbBucket::KeyVal x(byte_view(it2->first), it2->second);
-        ++it2;
-        return x;
-      });
-
       bottom_node.empty[nibble] = hasher.empty();
 
       if (!hasher.empty()) {
         bottom_node.hash[nibble] = hasher.hash();
       }
 
+      bottom_node.dirty = true;
       bottom_node.synced[nibble] = true;
     }
 
@@ -432,9 +844,9 @@ void State::process_leaves_reply(const Prefix prefix,
 
         parent.empty[nibble] = child.empty.all();
         if (!parent.empty[nibble]) {
-          parent.hash[nibble] =
-              mptrie::branch_node_hash(child.empty, child.hash);
+          parent.hash[nibble] = branch_hash(child);
         }
+        parent.dirty = true;
         parent.synced[nibble] = true;
       }
     }
@@ -444,10 +856,34 @@ void State::process_leaves_reply(const Prefix prefix,
   const auto start_from =
       static_cast<uint8_t>(prefix.size() - reply.proof.size());
   for (auto level = start_from; level < prefix.size(); ++level) {
-    update_node(node(level, prefix), reply.proof[level - start_from], rb);
+    update_node(level, prefix, reply.proof[level - start_from], rb);
   }
 
   propagate_synced_up(prefix, prefix.size() - 1);
+  return true;
+}
+
+bool State::proof_fits(const Prefix prefix, const sync::LeavesReply& reply,
+                       const sync::Verdict& verdict) const {
+  const int32_t rb = reply.block_number;
+  if (rb > root().block) {
+    // TODO check the root against the block header
+    return reply.proof.size() == prefix.size();
+  }
+
+  // a partial proof continues the path the leecher has for this block
+  const auto start_from =
+      static_cast<uint8_t>(prefix.size() - reply.proof.size());
+  if (start_from == 0) {
+    return verdict.top_empty == root().empty.all() &&
+           (verdict.top_empty || verdict.top_hash == root_hash());
+  }
+  if (consistent_path_depth(prefix) < start_from) {
+    return false;
+  }
+  const auto& parent = node(start_from - 1, prefix);
+  const auto nibble = prefix[start_from - 1];
+  return !nibble_obsolete(parent, nibble, verdict.top_empty, verdict.top_hash);
 }
 
 void State::propagate_synced_up(const Prefix prefix, const uint8_t from_level) {
@@ -459,7 +895,9 @@ void State::propagate_synced_up(const Prefix prefix, const uint8_t from_level) {
   }
 }
 
-void State::update_node(Node& nd, const sync::Proof& proof, int32_t new_block) {
+void State::update_node(const uint8_t level, const Prefix prefix,
+                        const sync::Proof& proof, const int32_t new_block) {
+  auto& nd = node(level, prefix);
   if (new_block <= nd.block) {
     return;
   }
@@ -467,34 +905,62 @@ void State::update_node(Node& nd, const sync::Proof& proof, int32_t new_block) {
   for (Nibble j = 0; j < 16; ++j) {
     if (nibble_obsolete(nd, j, proof.empty[j], proof.hash[j])) {
       nd.synced[j] = false;
+      mark_unsynced(level, prefix, j);
+      mark_stale(level, prefix, j);
     }
   }
 
-  nd.empty = proof.empty;
-  nd.hash = proof.hash;
+  if (nd.empty != proof.empty || nd.hash != proof.hash) {
+    nd.empty = proof.empty;
+    nd.hash = proof.hash;
+    nd.dirty = true;
+  }
   nd.block = new_block;
 }
 
 std::optional<sync::NodeReply> State::get_nodes(
     const sync::GetNodeRequest& request) const {
-  if (request.block_number &&
-      static_cast<int32_t>(*request.block_number) > root().block) {
-    return {};
+  int32_t block = root().block;
+  if (request.block_number) {
+    const auto rb = static_cast<int32_t>(*request.block_number);
+    if (rb > block) {
+      return {};
+    }
+
+    // the root is always served at the newest block
+    // so that leechers find out about it
+    const bool has_root =
+        std::any_of(request.prefixes.begin(), request.prefixes.end(),
+                    [](const Prefix& p) { return p.size() == 0; });
+    if (!has_root && has_history(rb)) {
+      block = rb;
+    }
   }
 
   sync::NodeReply reply;
-  reply.block_number = root().block;
+  reply.block_number = block;
+  reply.head_block = std::max(root().block, 0);
   reply.nodes.resize(request.prefixes.size());
 
   for (size_t i = 0; i < reply.nodes.size(); ++i) {
     const auto prefix = request.prefixes[i];
 
     if (prefix.size() >= depth()) {
-      // TODO implement
+      if (prefix.size() >= hash_depth_ || block < root().block) {
+        continue;
+      }
+      const Prefix path(depth(), prefix.padded());
+      if (consistent_path_depth(path) == depth() &&
+          node(depth() - 1, path).synced[path.last()]) {
+        reply.nodes[i] = deep_node(prefix);
+      }
       continue;
     }
 
-    if (consistent_path_depth(prefix) == prefix.size()) {
+    if (block < root().block) {
+      const auto& nd = node_at(prefix.size(), prefix, block);
+      reply.nodes[i] = sync::Proof{nd.empty, nd.hash};
+    } else if (consistent_path_depth(prefix) == prefix.size()) {
       const auto& nd = node(prefix.size(), prefix);
       reply.nodes[i] = sync::Proof{nd.empty, nd.hash};
     }
@@ -503,16 +969,50 @@ std::optional<sync::NodeReply> State::get_nodes(
   return reply;
 }
 
+sync::Proof State::deep_node(const Prefix prefix) const {
+  if (node_cache_) {
+    if (const auto cached = node_cache_->find(prefix)) {
+      return *cached;
+    }
+  }
+
+  std::vector<sync::Leaf> leaves;
+  db_util::iterate(db_, prefix,
+                   [&leaves](std::string_view key, std::string_view val) {
+                     leaves.emplace_back(string_to_hash(key), val);
+                   });
+  const auto nd = sync::subtree_node(prefix.size(), hash_depth_, leaves,
+                                     sync::hash_leaves(leaves));
+
+  if (node_cache_) {
+    node_cache_->insert(prefix, nd);
+  }
+  return nd;
+}
+
+sync::Proof State::node_on_path(const uint8_t level,
+                                const Prefix prefix) const {
+  if (level >= depth()) {
+    return deep_node(Prefix(level, prefix.padded()));
+  }
+  const auto& nd = node(level, prefix);
+  return sync::Proof{nd.empty, nd.hash};
+}
+
 void State::process_node_reply(const sync::GetNodeRequest& request,
                                const sync::NodeReply& reply) {
   if (reply.nodes.size() != request.prefixes.size()) {
     throw std::runtime_error("reply.nodes.size != request.prefixes.size");
   }
 
+  sync::Profiler::Scope scope(profiler_, sync::Profiler::kNodeReply,
+                              sync_phase());
+
   int32_t block_num = reply.block_number;
   if (block_num < root().block) {
     return;  // old reply
   }
+  const bool newer = block_num > root().block;
 
   for (size_t i = 0; i < reply.nodes.size(); ++i) {
     const auto nd = reply.nodes[i];
@@ -531,14 +1031,18 @@ void State::process_node_reply(const sync::GetNodeRequest& request,
       continue;
     }
 
-    update_node(node(prefix.size(), prefix), *nd, block_num);
+    update_node(prefix.size(), prefix, *nd, block_num);
     propagate_synced_up(prefix, prefix.size());
   }
 
-  if (block_num > root().block) {
-    // root block is stale
-    phase2_node_cursor_ = Prefix(0);
+  if (newer) {
+    // Walk the tree again from the new root, or fetch the root first if
+    // this reply didn't have it. The walk might have finished against
+    // the old root while the request was in flight.
+    phase2_node_cursor_ = root().block == block_num ? Prefix(1) : Prefix(0);
   }
 }
 
+void State::resume_sync() { phase2_node_cursor_ = Prefix(0); }
+
 }  // namespace silkworm
@@ -18,12 +18,22 @@
 #define SILKWORM_CORE_STATE_HPP_
 
 #include <bitset>
+#include <deque>
+#include <optional>
+#include <set>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/move/utility_core.hpp>
 
 #include "db_bucket.hpp"
+#include "hierarchical_bitmap.hpp"
+#include "node_cache.hpp"
 #include "sync.hpp"
+#include "profiler.hpp"
+#include "reply_cache.hpp"
+#include "undo_journal.hpp"
+#include "verifier.hpp"
 
 namespace silkworm {
 
@@ -35,27 +45,103 @@ class State {
 
   uint8_t depth() const { return static_cast<uint8_t>(tree_.size()); }
 
+  // depth the leaves are hashed with, which peers must agree on;
+  // >= depth()
+  uint8_t hash_depth() const { return hash_depth_; }
+
   void init_from_db(uint32_t data_valid_for_block);
 
+  // Rebuilds the tree with new depths from the leaves in the db.
+  // The nodes are not tied to any block afterwards, so phase 2 revalidates
+  // them against the peer, re-downloading only the leaves that differ.
+  // Call init_from_db instead if the data is known to be valid for a block.
+  void restructure(uint8_t depth, uint8_t phase1_depth);
+
+  uint8_t phase1_depth() const { return phase1_cursor_.size(); }
+
+  // Phase 1 goes on at the new depth from where it got to,
+  // re-requesting the rest of a partly done prefix when made shallower.
+  void set_phase1_depth(uint8_t phase1_depth);
+
   void put(Hash key, std::string val);
 
+  void del(Hash key);
+
+  // Journals the changes of the last max_blocks blocks, as sealed by
+  // init_from_db, so that they can be unwound.
+  void keep_undo_journal(uint32_t max_blocks);
+
+  // Rolls the db and the tree back to the given block,
+  // rehashing only the paths of the changed leaves.
+  void unwind(uint32_t block);
+
+  // Keeps the versions of the tree of the last num_blocks blocks so that
+  // requests pinned to any of them are answered at that block rather than
+  // the newest one, sparing leechers restarted proofs in phase 2.
+  // Old leaves come from the undo journal, which must be kept too.
+  void keep_history(uint32_t num_blocks);
+
+  // Keeps up to max_bytes of leaves replies at the newest block for
+  // get_leaves to serve the same requests again from, e.g. from a swarm
+  // of leechers.
+  void cache_replies(size_t max_bytes) { reply_cache_.emplace(max_bytes); }
+
+  // Rehashes the tree as one of the given depth, so that leechers that
+  // can afford a deeper tree than this one keeps in memory sync off it.
+  // The nodes below depth() are computed from the db as asked for, the
+  // last max_nodes of them cached. Seeder side only: such a state can
+  // serve the deeper tree but not sync it. Undone by restructure.
+  void hash_deeper(uint8_t hash_depth, size_t max_nodes);
+
+  // null unless cache_replies
+  const ReplyCache* reply_cache() const {
+    return reply_cache_ ? &*reply_cache_ : nullptr;
+  }
+
+  // Not thread-safe though const: get_leaves fills the reply cache and
+  // both fill the node cache, unlocked, as does root_hash the own_hash of
+  // dirty nodes. Callers must serialize all calls on one State.
   sync::LeavesReply get_leaves(const sync::GetLeavesRequest&) const;
 
   std::optional<sync::NodeReply> get_nodes(const sync::GetNodeRequest&) const;
 
   bool phase1_sync_done() const { return phase1_sync_done_; }
 
-  std::variant<std::monostate, sync::GetLeavesRequest, sync::GetNodeRequest>
-  next_sync_request();
+  sync::Request next_sync_request();
 
-  void process_leaves_reply(Prefix, const sync::LeavesReply&);
+  // If a verdict is given, the reply must have passed sync::verify;
+  // it is then also checked against the tree and returns false without
+  // touching the db if it doesn't fit.
+  bool process_leaves_reply(Prefix, const sync::LeavesReply&,
+                            const sync::Verdict* = nullptr);
 
   void process_node_reply(const sync::GetNodeRequest&, const sync::NodeReply&);
 
+  // Refetches the root and restarts phase 2 from it, e.g. once the peer
+  // is known to have moved on to a newer block.
+  void resume_sync();
+
+  // Has process_leaves_reply collect the keys of the leaves it writes
+  // from now on, so that data derived from the leaves can be rechecked
+  // for those only.
+  void track_changed_keys();
+
+  // Keys collected since the last call or track_changed_keys.
+  std::set<Hash> take_changed_keys();
+
+  // Times the sync steps into the profiler, if not null.
+  void set_profiler(sync::Profiler* profiler) { profiler_ = profiler; }
+
   int32_t synced_block() const {
     return root().synced.all() ? root().block : -1;
   }
 
+  Hash root_hash() const;
+
+  // Root hash of a tree of the given depth holding the leaves,
+  // which must be strictly ordered by key.
+  static Hash root_hash(uint8_t depth, const std::vector<sync::Leaf>& leaves);
+
  private:
   BOOST_MOVABLE_BUT_NOT_COPYABLE(State)
 
@@ -67,20 +153,80 @@ class State {
     // may only be true if the corresponding subtree is fully
     // consistent with the parent and has all its leaves in the db
     std::bitset<16> synced;
+
+    // mptrie::branch_node_hash of empty & hash unless dirty, which must
+    // be set whenever either changes; see branch_hash
+    mutable Hash own_hash;
+    mutable bool dirty = true;
   };
 
+  // The hash of the node as its parent has it, rehashed only if dirty.
+  static const Hash& branch_hash(const Node&);
+
   DbBucket& db_;
 
   // TODO unify with mptrie
   // Invariant: parent.block >= child.block if parent.block != -1.
   std::vector<std::vector<Node>> tree_;
 
+  uint8_t hash_depth_;
+
+  // nodes below the tree, see hash_deeper
+  mutable std::optional<NodeCache> node_cache_;
+
+  // A bit per bottom nibble that might need leaves in phase 2, so that
+  // next_leaves_request skips the ones known to be synced and consistent
+  // with the root. Set whenever a nibble's subtree becomes unsynced;
+  // cleared by next_leaves_request a synced subtree at a time.
+  HierarchicalBitmap unsynced_;
+
+  // A bitmap per level with a bit per node that might be behind the root,
+  // so that next_node_request visits those only. Set for the children
+  // whose hash changes when a node is updated; cleared by
+  // next_node_request once the node has caught up.
+  std::vector<HierarchicalBitmap> stale_;
+
   Prefix phase1_cursor_;
   Prefix phase2_leaf_cursor_;
   Prefix phase2_node_cursor_ = Prefix(1);
 
   bool phase1_sync_done_ = false;
 
+  std::optional<UndoJournal> journal_;
+
+  // null unless track_changed_keys
+  std::optional<std::set<Hash>> changed_keys_;
+
+  sync::Profiler* profiler_ = nullptr;
+
+  unsigned sync_phase() const { return phase1_sync_done_ ? 2 : 1; }
+
+  // Nodes as of a past block that the next block changed (copy-on-write)
+  struct Version {
+    int32_t block;
+    std::vector<std::unordered_map<uint64_t, Node>> nodes;  // per level
+  };
+
+  uint32_t history_blocks_ = 0;
+  int32_t history_head_ = -1;  // the block the current nodes are valid for
+  std::deque<Version> history_;
+
+  mutable std::optional<ReplyCache> reply_cache_;
+
+  void save_history(int32_t new_block);
+
+  bool has_history(int32_t block) const;
+
+  // requires has_history(block)
+  const Node& node_at(uint8_t level, Prefix, int32_t block) const;
+
+  sync::LeavesReply get_leaves_at(const sync::GetLeavesRequest&,
+                                  int32_t block) const;
+
+  void reset_tree(uint8_t depth, uint8_t phase1_depth);
+
+  void rehash_from_db(int32_t block);
+
   sync::GetNodeRequest next_node_request();
   std::optional<sync::GetLeavesRequest> next_leaves_request(Prefix&,
                                                             bool phase1);
@@ -89,6 +235,12 @@ class State {
     return level == 0 ? 0 : prefix.val() >> (64 - level * 4);
   }
 
+  // The node at prefix.size() >= depth(), computed from the leaves.
+  sync::Proof deep_node(Prefix) const;
+
+  // The node at the level of the path, from the tree or computed.
+  sync::Proof node_on_path(uint8_t level, Prefix) const;
+
   const Node& node(uint8_t level, Prefix prefix) const {
     return tree_[level][node_index(level, prefix)];
   }
@@ -100,6 +252,17 @@ class State {
   Node& root() { return tree_[0][0]; }
   const Node& root() const { return tree_[0][0]; }
 
+  void invalidate_path(const Hash& key);
+
+  // db_util::replace, collecting the changed keys if tracked
+  void replace_leaves(Prefix, const sync::LeafBatch&);
+
+  // Sets the bits of unsynced_ below the nibble of the node.
+  void mark_unsynced(uint8_t level, Prefix, Nibble);
+
+  // Sets the bit of stale_ for the child at the nibble of the node.
+  void mark_stale(uint8_t level, Prefix, Nibble);
+
   void update_blocks_down_path(Prefix);
   bool update_block_at(Prefix, uint8_t level);
 
@@ -107,7 +270,11 @@ class State {
 
   void propagate_synced_up(Prefix, uint8_t from_level);
 
-  void update_node(Node&, const sync::Proof& new_data, int32_t new_block);
+  void update_node(uint8_t level, Prefix, const sync::Proof& new_data,
+                   int32_t new_block);
+
+  bool proof_fits(Prefix, const sync::LeavesReply&,
+                  const sync::Verdict&) const;
 
   static bool nibble_obsolete(const Node&, Nibble, bool new_empty,
                               const Hash& new_hash);
@@ -0,0 +1,248 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "storage_sync.hpp"
+
+#include <algorithm>
+
+#include "account.hpp"
+
+namespace silkworm {
+
+Hash storage_root(const std::vector<sync::Leaf>& leaves) {
+  if (leaves.empty()) {
+    return kEmptyStringHash;
+  }
+  return State::root_hash(sync::kStorageTrieDepth, leaves);
+}
+
+std::vector<sync::Leaf> read_storage(DbBucket& storage_db,
+                                     const Hash& account) {
+  std::vector<sync::Leaf> leaves;
+  PrefixedDbBucket(storage_db, byte_view(account))
+      .get("", {}, [&leaves](std::string_view key, std::string_view val) {
+        leaves.emplace_back(string_to_hash(key), val);
+      });
+  return leaves;
+}
+
+StorageSync::StorageSync(const DbBucket& state_db, DbBucket& storage_db,
+                         uint32_t block)
+    : state_db_(state_db), storage_db_(storage_db), block_(block) {
+  state_db.get("", {}, [this](std::string_view key, std::string_view val) {
+    check_trie(string_to_hash(key), account_from_rlp(val).storage);
+  });
+}
+
+void StorageSync::move_to_block(uint32_t block,
+                                const std::set<Hash>& changed_accounts) {
+  auto accounts = changed_accounts;
+  for (const auto& trie : small_) {
+    accounts.insert(trie.account);
+  }
+  for (const auto& trie : large_) {
+    accounts.insert(trie.account);
+  }
+  for (const auto& requested : requested_) {
+    accounts.insert(requested.first);
+  }
+  if (current_) {
+    accounts.insert(current_->account);
+  }
+
+  small_.clear();
+  requested_.clear();
+  large_.clear();
+  current_.reset();
+  current_trie_.reset();
+
+  block_ = block;
+  outdated_ = false;
+
+  for (const auto& account : accounts) {
+    const auto val = state_db_.get(byte_view(account));
+    check_trie(account,
+               val ? account_from_rlp(*val).storage : kEmptyStringHash);
+  }
+}
+
+void StorageSync::check_trie(const Hash& account, const Hash& root) {
+  const auto it = verified_.find(account);
+  if (it != verified_.end()) {
+    if (it->second == root) {
+      return;
+    }
+    verified_.erase(it);
+  } else if (root != kEmptyStringHash &&
+             storage_root(read_storage(storage_db_, account)) == root) {
+    verified_.emplace(account, root);
+    return;
+  }
+
+  if (root != kEmptyStringHash) {
+    small_.push_back(Trie{account, root});
+  }
+}
+
+bool StorageSync::done() const {
+  return !outdated_ && small_.empty() && requested_.empty() &&
+         large_.empty() && !current_;
+}
+
+sync::Request StorageSync::next_sync_request() {
+  if (outdated_) {
+    return {};
+  }
+
+  if (current_) {
+    auto request = current_trie_->state.next_sync_request();
+    if (auto leaves_request = std::get_if<sync::GetLeavesRequest>(&request)) {
+      leaves_request->account = current_->account;
+      return request;
+    } else if (auto node_request =
+                   std::get_if<sync::GetNodeRequest>(&request)) {
+      node_request->account = current_->account;
+      return request;
+    }
+  }
+
+  if (!small_.empty()) {
+    sync::GetStorageRequest request;
+    request.block_number = block_;
+    while (!small_.empty() &&
+           request.accounts.size() < sync::kMaxAccountsPerStorageRequest) {
+      const auto trie = small_.front();
+      small_.pop_front();
+      request.accounts.push_back(trie.account);
+      requested_[trie.account] = trie.root;
+    }
+    return request;
+  }
+
+  if (!current_ && !large_.empty()) {
+    start_large_trie();
+    return next_sync_request();
+  }
+
+  return {};
+}
+
+void StorageSync::start_large_trie() {
+  current_ = large_.front();
+  large_.pop_front();
+
+  sync::Hints hints;
+  hints.num_leaves = current_->num_leaves;
+  const auto phase1_depth =
+      std::min(hints.optimal_phase1_depth(), sync::kStorageTrieDepth);
+
+  current_trie_ = std::make_unique<StorageTrie>(storage_db_, current_->account,
+                                                phase1_depth);
+  // stale leaves wouldn't be deleted by phase 1
+  current_trie_->db.del("", {});
+}
+
+void StorageSync::check_large_trie() {
+  if (current_trie_->state.synced_block() < 0) {
+    return;
+  }
+
+  if (current_trie_->state.root_hash() == current_->root) {
+    verified_.emplace(current_->account, current_->root);
+  } else {
+    outdated_ = true;
+    large_.push_back(*current_);  // for move_to_block to recheck
+  }
+
+  current_.reset();
+  current_trie_.reset();
+}
+
+void StorageSync::process_storage_reply(const sync::GetStorageRequest& request,
+                                        const sync::StorageReply& reply) {
+  if (reply.storage.size() != request.accounts.size()) {
+    throw std::runtime_error("reply.storage.size != request.accounts.size");
+  }
+
+  for (size_t i = 0; i < request.accounts.size(); ++i) {
+    const auto& account = request.accounts[i];
+    const auto it = requested_.find(account);
+    if (it == requested_.end()) {
+      continue;
+    }
+    const Trie trie{account, it->second};
+    requested_.erase(it);
+
+    const auto& storage = reply.storage[i];
+
+    switch (storage.status) {
+      case sync::LeavesReply::kOK: {
+        if (storage_root(storage.leaves) != trie.root) {
+          outdated_ = true;
+          small_.push_back(trie);  // for move_to_block to recheck
+          break;
+        }
+        verified_.emplace(account, trie.root);
+
+        PrefixedDbBucket db(storage_db_, byte_view(account));
+        db.del("", {});
+
+        auto leaf = storage.leaves.begin();
+        const auto end = storage.leaves.end();
+        db.put([&leaf, end]() -> std::optional<DbBucket::KeyVal> {
+          if (leaf == end) {
+            return {};
+          }
+          DbBucket::KeyVal x(byte_view(leaf->first), leaf->second);
+          ++leaf;
+          return x;
+        });
+        break;
+      }
+      case sync::LeavesReply::kDontHaveData:
+        small_.push_back(trie);
+        break;
+      case sync::LeavesReply::kTooManyLeaves:
+        large_.push_back(Trie{account, trie.root, storage.num_leaves});
+        break;
+    }
+  }
+}
+
+bool StorageSync::process_leaves_reply(const sync::GetLeavesRequest& request,
+                                       const sync::LeavesReply& reply,
+                                       const sync::Verdict* verdict) {
+  if (!current_ || request.account != current_->account) {
+    return true;  // old reply
+  }
+  if (!current_trie_->state.process_leaves_reply(request.prefix, reply,
+                                                 verdict)) {
+    return false;
+  }
+  check_large_trie();
+  return true;
+}
+
+void StorageSync::process_node_reply(const sync::GetNodeRequest& request,
+                                     const sync::NodeReply& reply) {
+  if (!current_ || request.account != current_->account) {
+    return;  // old reply
+  }
+  current_trie_->state.process_node_reply(request, reply);
+  check_large_trie();
+}
+
+}  // namespace silkworm
@@ -0,0 +1,119 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_STORAGE_SYNC_HPP_
+#define SILKWORM_CORE_STORAGE_SYNC_HPP_
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "prefixed_db_bucket.hpp"
+#include "state.hpp"
+#include "sync.hpp"
+
+// Storage of all accounts is kept in one bucket
+// with keys keccak(address) + keccak(location).
+
+namespace silkworm {
+
+// kEmptyStringHash if there are no leaves, as in Account::storage
+Hash storage_root(const std::vector<sync::Leaf>& leaves);
+
+std::vector<sync::Leaf> read_storage(DbBucket& storage_db,
+                                     const Hash& account);
+
+// Storage trie of a single account
+struct StorageTrie {
+  StorageTrie(DbBucket& storage_db, const Hash& account, uint8_t phase1_depth)
+      : db{storage_db, byte_view(account)},
+        state{db, sync::kStorageTrieDepth, phase1_depth} {}
+
+  PrefixedDbBucket db;
+  State state;
+};
+
+// Leecher side of storage sync, to be run once the state trie is synced.
+// Fetches the storage of every account whose storage root doesn't match
+// the storage in the db, batching small tries and syncing large ones
+// one at a time with the two-phase algorithm.
+class StorageSync {
+ public:
+  StorageSync(const DbBucket& state_db, DbBucket& storage_db, uint32_t block);
+
+  // block of the state trie the storage roots are taken from
+  uint32_t block() const { return block_; }
+
+  // Carries on at a newer block of the state trie, or at the same one
+  // once outdated, rechecking only the accounts whose leaves changed
+  // since the last block and the tries not synced yet rather than
+  // scanning every account again.
+  void move_to_block(uint32_t block, const std::set<Hash>& changed_accounts);
+
+  bool done() const;
+
+  // A trie didn't match its root as of block(), so the peer has moved
+  // on; the state trie must be synced to the new block first.
+  bool outdated() const { return outdated_; }
+
+  sync::Request next_sync_request();
+
+  void process_storage_reply(const sync::GetStorageRequest&,
+                             const sync::StorageReply&);
+
+  // see State::process_leaves_reply
+  bool process_leaves_reply(const sync::GetLeavesRequest&,
+                            const sync::LeavesReply&,
+                            const sync::Verdict* = nullptr);
+
+  void process_node_reply(const sync::GetNodeRequest&,
+                          const sync::NodeReply&);
+
+ private:
+  struct Trie {
+    Hash account;
+    Hash root;
+    uint64_t num_leaves = 0;  // only known for large tries
+  };
+
+  const DbBucket& state_db_;
+  DbBucket& storage_db_;
+  uint32_t block_;
+  bool outdated_ = false;
+
+  // account -> storage root that the storage in the db is known to match
+  std::map<Hash, Hash> verified_;
+
+  std::deque<Trie> small_;
+  std::map<Hash, Hash> requested_;  // account -> root
+  std::deque<Trie> large_;
+
+  // the large trie being synced
+  std::optional<Trie> current_;
+  std::unique_ptr<StorageTrie> current_trie_;
+
+  // Queues the trie unless the storage in the db matches the root.
+  void check_trie(const Hash& account, const Hash& root);
+
+  void start_large_trie();
+  void check_large_trie();
+};
+
+}  // namespace silkworm
+
+#endif  // SILKWORM_CORE_STORAGE_SYNC_HPP_
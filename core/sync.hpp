@@ -20,10 +20,12 @@
 #include <bitset>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
 #include "common.hpp"
+#include "leaf_batch.hpp"
 #include "prefix.hpp"
 
 /* Sync Research
@@ -32,16 +34,17 @@
   * describe the algo
   * theoretical convergence
   * experimental convergence with ~100m dust accounts
+  * storage tries. pack multiple accounts into 1 request/reply for small tries
+  * chain reorgs: per-block undo journal on the miner side
+  * leaf proof checking, on worker threads
 [TODO]
   * unify the protocol with Firehose
   * finish the doc and post it for discussions
-  * storage tries. pack multiple accounts into 1 request/reply for small tries
+  * storage tries: keep them in sync with later blocks
   * extension/leaf nodes (prereq: Issue #7, better test coverage)
-  * handle chain reorgs
   * use the real protocol in the modelling code
   * network layer, p2p
   * multiple leechers, BitTorrent-like swarm
-  * leaf proof checking
   * compare against geth's fast sync and parity's warp sync
   * real historical Ethereum data
 */
@@ -50,8 +53,8 @@ namespace silkworm::sync {
 
 // TODO move to protocol
 struct GetLeavesRequest {
-  // {} account means state rather than storage trie
-  std::optional<Address> account = {};
+  // keccak of the address; {} account means state rather than storage trie
+  std::optional<Hash> account = {};
 
   // request all leaves with this prefix
   Prefix prefix;
@@ -65,15 +68,17 @@ struct GetLeavesRequest {
   // otherwise full proof is required.
   uint8_t from_level = 0;  // <= prefix.size
 
+  // The requester's hash of the prefix's subtree, i.e. that of the nibble
+  // in the node above. If it's still current, leaves are left out.
+  std::optional<Hash> hash;
+
   explicit GetLeavesRequest(Prefix prefix) : prefix{prefix} {}
 
   size_t byte_size() const {
-    return sizeof(*this) + (account ? kAddressBytes : 0);
+    return sizeof(*this) + (account ? kHashBytes : 0) + (hash ? kHashBytes : 0);
   }
 };
 
-using Leaf = std::pair<Hash, std::string>;
-
 // a reasonable approximation for dust accounts
 static constexpr size_t kLeafSize = sizeof(Leaf) + 80;
 
@@ -96,15 +101,18 @@ struct LeavesReply {
   // must be >= request.block_number
   uint32_t block_number = 0;
 
+  // newest block of the peer; greater than block_number if the reply
+  // is pinned to an older block as requested
+  uint32_t head_block = 0;
+
   // If block_number = request.block_number
   // proof.size = prefix.size - from_level // TODO extension/leaf nodes
   // else if block_number > request.block_number || request.block_number not set
   // proof.size = prefix.size
   std::vector<Proof> proof;
 
-  // don't send leaves if hash(leaves) = request.hash, but send proof anyway
-  std::optional<std::vector<Leaf>>
-      leaves;  // must be strictly ordered by hash_key
+  // not sent if the subtree hash = request.hash, but proof is anyway
+  std::optional<LeafBatch> leaves;  // must be strictly ordered by hash_key
 
   size_t byte_size() const {
     auto sz = sizeof(*this) + proof.size() * sizeof(Proof);
@@ -117,8 +125,8 @@ struct LeavesReply {
 
 // uses prefixes unlike PV63
 struct GetNodeRequest {
-  // {} account means state rather than storage trie
-  std::optional<Address> account = {};
+  // keccak of the address; {} account means state rather than storage trie
+  std::optional<Hash> account = {};
 
   std::vector<Prefix> prefixes;
 
@@ -126,7 +134,7 @@ struct GetNodeRequest {
   std::optional<uint32_t> block_number;
 
   size_t byte_size() const {
-    return sizeof(*this) + (account ? kAddressBytes : 0) +
+    return sizeof(*this) + (account ? kHashBytes : 0) +
            prefixes.size() * sizeof(Prefix);
   }
 };
@@ -135,6 +143,9 @@ struct NodeReply {
   // must be >= request.block_number
   uint32_t block_number = 0;
 
+  // see LeavesReply
+  uint32_t head_block = 0;
+
   std::vector<std::optional<Proof>> nodes;
 
   size_t byte_size() const {
@@ -142,7 +153,74 @@ struct NodeReply {
   }
 };
 
-// TODO: GetStorageSize
+// Storage tries are synced with a fixed depth, so their root hashes don't
+// depend on the hints. Tries small enough to fit into a batch are packed
+// many per GetStorageRequest; larger ones get the two-phase algorithm
+// via GetLeavesRequest & GetNodeRequest with the account set.
+static constexpr uint8_t kStorageTrieDepth = 3;
+static constexpr size_t kMaxAccountsPerStorageRequest = 64;
+static constexpr size_t kMaxLeavesPerStorageReply = 256;
+
+struct GetStorageRequest {
+  // keccak of the addresses
+  std::vector<Hash> accounts;
+
+  // may not respond with older data
+  std::optional<uint32_t> block_number;
+
+  size_t byte_size() const {
+    return sizeof(*this) + accounts.size() * kHashBytes;
+  }
+};
+
+struct StorageReply {
+  struct Storage {
+    // kDontHaveData if the trie didn't fit into this reply, try again;
+    // kTooManyLeaves if it never fits, sync it with GetLeavesRequest
+    LeavesReply::Status status = LeavesReply::kOK;
+
+    // only set if status = kTooManyLeaves
+    uint64_t num_leaves = 0;
+
+    std::vector<Leaf> leaves;  // must be strictly ordered by hash_key
+  };
+
+  // must be >= request.block_number
+  uint32_t block_number = 0;
+
+  std::vector<Storage> storage;  // one per requested account
+
+  size_t byte_size() const {
+    auto sz = sizeof(*this);
+    for (const auto& x : storage) {
+      sz += sizeof(x) + x.leaves.size() * kLeafSize;
+    }
+    return sz;
+  }
+};
+
+using Request = std::variant<std::monostate, GetLeavesRequest, GetNodeRequest,
+                             GetStorageRequest>;
+
+using Reply = std::variant<LeavesReply, NodeReply, StorageReply>;
+
+inline size_t byte_size(const Request& request) {
+  return std::visit(
+      [](const auto& x) -> size_t {
+        if constexpr (std::is_same_v<std::decay_t<decltype(x)>,
+                                     std::monostate>) {
+          return 0;
+        } else {
+          return x.byte_size();
+        }
+      },
+      request);
+}
+
+inline size_t byte_size(const Reply& reply) {
+  return std::visit([](const auto& x) { return x.byte_size(); }, reply);
+}
+
 
 struct Stats {
   uint64_t num_requests = 0;
@@ -150,7 +228,10 @@ struct Stats {
   uint64_t num_replies = 0;
   uint64_t reply_total_bytes = 0;
   uint64_t reply_total_leaves = 0;
+  uint64_t reply_total_leaf_bytes = 0;  // actual keys & values
+  uint64_t reply_total_storage_leaves = 0;
   uint64_t reply_total_nodes = 0;
+  uint64_t num_rejected_replies = 0;  // failed verification
 };
 
 // all sizes are in bytes
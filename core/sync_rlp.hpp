@@ -0,0 +1,167 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_SYNC_RLP_HPP_
+#define SILKWORM_CORE_SYNC_RLP_HPP_
+
+#include <stdexcept>
+
+#include "mptrie.hpp"
+#include "prefix.hpp"
+#include "rlp_schema.hpp"
+#include "sync.hpp"
+
+// Wire encoding of the sync messages. Optional fields are lists of no
+// items or one; proof nodes are encoded as branch nodes.
+
+namespace silkworm::rlp {
+
+// [size, val]
+template <>
+struct Codec<Prefix> {
+  static size_t length(const Prefix& x) {
+    return list_encoded_length(payload_length(x));
+  }
+
+  static char* encode(const Prefix& x, char* out) {
+    out = encode_list_header(payload_length(x), out);
+    out = Codec<uint8_t>::encode(x.size(), out);
+    return Codec<uint64_t>::encode(x.val(), out);
+  }
+
+  static void decode(Reader& in, Prefix& x) {
+    auto items = in.read_list();
+    uint8_t size;
+    uint64_t val;
+    Codec<uint8_t>::decode(items, size);
+    Codec<uint64_t>::decode(items, val);
+    if (!items.empty() || size > 16) {
+      throw std::invalid_argument("bad prefix");
+    }
+    x = Prefix(size, val);
+  }
+
+ private:
+  static size_t payload_length(const Prefix& x) {
+    return Codec<uint8_t>::length(x.size()) + Codec<uint64_t>::length(x.val());
+  }
+};
+
+template <>
+struct Codec<sync::Proof> {
+  static size_t length(const sync::Proof& x) {
+    return mptrie::branch_node_rlp_length(x.empty);
+  }
+
+  static char* encode(const sync::Proof& x, char* out) {
+    return mptrie::branch_node_to_rlp(x.empty, x.hash, out);
+  }
+
+  static void decode(Reader& in, sync::Proof& x) {
+    mptrie::branch_node_from_rlp(in, x.empty, x.hash);
+  }
+};
+
+// as a list of [key, value] pairs
+template <>
+struct Codec<sync::LeafBatch> {
+  static size_t length(const sync::LeafBatch& x) {
+    return list_encoded_length(payload_length(x));
+  }
+
+  static char* encode(const sync::LeafBatch& x, char* out) {
+    out = encode_list_header(payload_length(x), out);
+    for (const auto& leaf : x) {
+      out = encode_list_header(leaf_payload_length(leaf), out);
+      out = Codec<Hash>::encode(leaf.first, out);
+      out = encode_string(leaf.second, out);
+    }
+    return out;
+  }
+
+  static void decode(Reader& in, sync::LeafBatch& x) {
+    auto items = in.read_list();
+    x.clear();
+    while (!items.empty()) {
+      auto leaf = items.read_list();
+      Hash key;
+      Codec<Hash>::decode(leaf, key);
+      x.push_back(key, leaf.read_string());
+      if (!leaf.empty()) {
+        throw std::invalid_argument("leaf with more than two items");
+      }
+    }
+  }
+
+ private:
+  static size_t leaf_payload_length(const sync::LeafBatch::Ref& leaf) {
+    return Codec<Hash>::length(leaf.first) + string_encoded_length(leaf.second);
+  }
+
+  static size_t payload_length(const sync::LeafBatch& x) {
+    size_t len = 0;
+    for (const auto& leaf : x) {
+      len += list_encoded_length(leaf_payload_length(leaf));
+    }
+    return len;
+  }
+};
+
+template <>
+struct Codec<sync::GetLeavesRequest>
+    : Schema<sync::GetLeavesRequest, &sync::GetLeavesRequest::account,
+             &sync::GetLeavesRequest::prefix,
+             &sync::GetLeavesRequest::block_number,
+             &sync::GetLeavesRequest::from_level,
+             &sync::GetLeavesRequest::hash> {};
+
+template <>
+struct Codec<sync::LeavesReply>
+    : Schema<sync::LeavesReply, &sync::LeavesReply::status,
+             &sync::LeavesReply::block_number, &sync::LeavesReply::head_block,
+             &sync::LeavesReply::proof, &sync::LeavesReply::leaves> {};
+
+template <>
+struct Codec<sync::GetNodeRequest>
+    : Schema<sync::GetNodeRequest, &sync::GetNodeRequest::account,
+             &sync::GetNodeRequest::prefixes,
+             &sync::GetNodeRequest::block_number> {};
+
+template <>
+struct Codec<sync::NodeReply>
+    : Schema<sync::NodeReply, &sync::NodeReply::block_number,
+             &sync::NodeReply::head_block, &sync::NodeReply::nodes> {};
+
+template <>
+struct Codec<sync::GetStorageRequest>
+    : Schema<sync::GetStorageRequest, &sync::GetStorageRequest::accounts,
+             &sync::GetStorageRequest::block_number> {};
+
+template <>
+struct Codec<sync::StorageReply::Storage>
+    : Schema<sync::StorageReply::Storage,
+             &sync::StorageReply::Storage::status,
+             &sync::StorageReply::Storage::num_leaves,
+             &sync::StorageReply::Storage::leaves> {};
+
+template <>
+struct Codec<sync::StorageReply>
+    : Schema<sync::StorageReply, &sync::StorageReply::block_number,
+             &sync::StorageReply::storage> {};
+
+}  // namespace silkworm::rlp
+
+#endif  // SILKWORM_CORE_SYNC_RLP_HPP_
@@ -0,0 +1,60 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "tuner.hpp"
+
+#include <algorithm>
+
+namespace silkworm::sync {
+
+void Tuner::observe(const DbBucket& db) {
+  db_leaves_ = 0;
+  db_leaf_bytes_ = 0;
+  db.get("", {}, [this](std::string_view key, std::string_view val) {
+    ++db_leaves_;
+    db_leaf_bytes_ += key.size() + val.size();
+  });
+}
+
+void Tuner::observe(const Stats& stats) {
+  reply_leaves_ = stats.reply_total_leaves;
+  reply_leaf_bytes_ = stats.reply_total_leaf_bytes;
+}
+
+void Tuner::observe_blocks(uint64_t num_blocks, uint64_t num_changes) {
+  num_blocks_ += num_blocks;
+  num_changes_ += num_changes;
+}
+
+Hints Tuner::hints() const {
+  Hints hints = initial_;
+
+  if (db_leaves_ != 0) {
+    hints.num_leaves = db_leaves_;
+    hints.leaf_size = static_cast<unsigned>(db_leaf_bytes_ / db_leaves_);
+  } else if (reply_leaves_ != 0) {
+    hints.leaf_size = static_cast<unsigned>(reply_leaf_bytes_ / reply_leaves_);
+  }
+
+  if (num_blocks_ != 0) {
+    hints.changes_per_block =
+        std::max(1u, static_cast<unsigned>(num_changes_ / num_blocks_));
+  }
+
+  return hints;
+}
+
+}  // namespace silkworm::sync
@@ -0,0 +1,57 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_TUNER_HPP_
+#define SILKWORM_CORE_TUNER_HPP_
+
+#include "db_bucket.hpp"
+#include "sync.hpp"
+
+namespace silkworm::sync {
+
+// Re-derives Hints from runtime measurements instead of the a priori
+// defaults, so that e.g. contract-heavy state with large leaves gets
+// shallower trees than dust.
+class Tuner {
+ public:
+  explicit Tuner(const Hints& initial) : initial_(initial) {}
+
+  // Measures the number of leaves and their average size.
+  void observe(const DbBucket&);
+
+  // Leaf sizes as received; only used if there's no db measurement.
+  void observe(const Stats&);
+
+  void observe_blocks(uint64_t num_blocks, uint64_t num_changes);
+
+  Hints hints() const;
+
+ private:
+  Hints initial_;
+
+  uint64_t db_leaves_ = 0;
+  uint64_t db_leaf_bytes_ = 0;
+
+  uint64_t reply_leaves_ = 0;
+  uint64_t reply_leaf_bytes_ = 0;
+
+  uint64_t num_blocks_ = 0;
+  uint64_t num_changes_ = 0;
+};
+
+}  // namespace silkworm::sync
+
+#endif  // SILKWORM_CORE_TUNER_HPP_
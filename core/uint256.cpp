@@ -0,0 +1,93 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "uint256.hpp"
+
+#include <algorithm>
+
+namespace silkworm {
+
+std::pair<UInt256, UInt256> UInt256::divmod(UInt256 x, const UInt256& y) {
+  if (!y) {
+    throw std::domain_error("division by zero");
+  }
+  if (x < y) {
+    return {0, x};
+  }
+
+#ifdef __SIZEOF_INT128__
+  if (y.bit_length() <= 64) {
+    // word by word, each step being a 128 by 64 bit division
+    const auto d = y.word(0);
+    UInt256 quotient;
+    UInt128 rem = 0;
+    for (unsigned i = 4; i-- > 0;) {
+      const auto cur = (rem << 64) | x.word(i);
+      quotient.set_word(i, static_cast<uint64_t>(cur / d));
+      rem = cur % d;
+    }
+    return {quotient, static_cast<uint64_t>(rem)};
+  }
+#else
+  if (y.bit_length() <= 32) {
+    // half word by half word, each step being a 64 by 32 bit division
+    const auto d = y.word(0);
+    UInt256 quotient;
+    uint64_t rem = 0;
+    for (unsigned i = 8; i-- > 0;) {
+      const auto cur = (rem << 32) | ((x.word(i / 2) >> (i % 2 * 32)) &
+                                      0xffff'ffff);
+      quotient.set_word(i / 2, quotient.word(i / 2) |
+                                   (cur / d) << (i % 2 * 32));
+      rem = cur % d;
+    }
+    return {quotient, rem};
+  }
+#endif
+
+  // the quotient has at most 224 bits, so shift & subtract is good enough
+  const auto shift = x.bit_length() - y.bit_length();
+  auto d = y << shift;
+  UInt256 quotient;
+  for (unsigned i = shift + 1; i-- > 0; d >>= 1) {
+    if (x >= d) {
+      x -= d;
+      quotient.set_word(i / 64, quotient.word(i / 64) | 1ull << (i % 64));
+    }
+  }
+  return {quotient, x};
+}
+
+std::string to_string(const UInt256& x) {
+  if (!x) {
+    return "0";
+  }
+
+  static constexpr uint64_t kChunk = 10'000'000'000'000'000'000ull;
+  std::string res;
+  for (auto rest = x; rest;) {
+    auto [quotient, rem] = UInt256::divmod(rest, kChunk);
+    auto digits = rem.word(0);
+    for (int i = 0; i < 19 && (quotient || digits); ++i, digits /= 10) {
+      res += static_cast<char>('0' + digits % 10);
+    }
+    rest = quotient;
+  }
+  std::reverse(res.begin(), res.end());
+  return res;
+}
+
+}  // namespace silkworm
@@ -0,0 +1,245 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_UINT256_HPP_
+#define SILKWORM_CORE_UINT256_HPP_
+
+#include <stdint.h>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "bits.hpp"
+
+namespace silkworm {
+
+#ifdef __SIZEOF_INT128__
+__extension__ using UInt128 = unsigned __int128;
+#endif
+
+// Unsigned 256-bit integer with wrap-around arithmetic, kept as four 64-bit
+// words, the least significant first.
+class UInt256 {
+ public:
+  constexpr UInt256() = default;
+
+  // implicit, as for the built-in integers
+  constexpr UInt256(uint64_t x) : words_{x, 0, 0, 0} {}  // NOLINT
+
+  constexpr uint64_t word(unsigned i) const { return words_[i]; }
+  constexpr void set_word(unsigned i, uint64_t x) { words_[i] = x; }
+
+  // number of significant bits, zero for zero
+  constexpr unsigned bit_length() const {
+    for (unsigned i = 4; i-- > 0;) {
+      if (words_[i]) {
+        return 64 * i + 64 - count_leading_zeros(words_[i]);
+      }
+    }
+    return 0;
+  }
+
+  constexpr explicit operator bool() const {
+    return (words_[0] | words_[1] | words_[2] | words_[3]) != 0;
+  }
+
+  constexpr UInt256& operator+=(const UInt256& y) {
+    uint64_t carry = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+      const auto sum = words_[i] + y.words_[i];
+      const auto res = sum + carry;
+      carry = (sum < words_[i]) | (res < sum);
+      words_[i] = res;
+    }
+    return *this;
+  }
+
+  constexpr UInt256& operator-=(const UInt256& y) {
+    uint64_t borrow = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+      const auto diff = words_[i] - y.words_[i];
+      const auto res = diff - borrow;
+      borrow = (words_[i] < y.words_[i]) | (diff < borrow);
+      words_[i] = res;
+    }
+    return *this;
+  }
+
+  constexpr UInt256& operator*=(const UInt256& y) {
+    uint64_t res[4] = {};
+    for (unsigned i = 0; i < 4; ++i) {
+      uint64_t carry = 0;
+      for (unsigned j = 0; i + j < 4; ++j) {
+        const auto [low, high] =
+            mul_add(words_[i], y.words_[j], res[i + j], carry);
+        res[i + j] = low;
+        carry = high;
+      }
+    }
+    for (unsigned i = 0; i < 4; ++i) {
+      words_[i] = res[i];
+    }
+    return *this;
+  }
+
+  UInt256& operator/=(const UInt256& y) {
+    return *this = divmod(*this, y).first;
+  }
+  UInt256& operator%=(const UInt256& y) {
+    return *this = divmod(*this, y).second;
+  }
+
+  constexpr UInt256& operator<<=(unsigned n) {
+    if (n >= 256) {
+      return *this = 0;
+    }
+    const auto shift_words = n / 64;
+    const auto shift_bits = n % 64;
+    for (unsigned i = 4; i-- > 0;) {
+      uint64_t x = 0;
+      if (i >= shift_words) {
+        x = words_[i - shift_words] << shift_bits;
+        if (shift_bits && i > shift_words) {
+          x |= words_[i - shift_words - 1] >> (64 - shift_bits);
+        }
+      }
+      words_[i] = x;
+    }
+    return *this;
+  }
+
+  constexpr UInt256& operator>>=(unsigned n) {
+    if (n >= 256) {
+      return *this = 0;
+    }
+    const auto shift_words = n / 64;
+    const auto shift_bits = n % 64;
+    for (unsigned i = 0; i < 4; ++i) {
+      uint64_t x = 0;
+      if (i + shift_words < 4) {
+        x = words_[i + shift_words] >> shift_bits;
+        if (shift_bits && i + shift_words + 1 < 4) {
+          x |= words_[i + shift_words + 1] << (64 - shift_bits);
+        }
+      }
+      words_[i] = x;
+    }
+    return *this;
+  }
+
+  constexpr UInt256& operator&=(const UInt256& y) {
+    for (unsigned i = 0; i < 4; ++i) {
+      words_[i] &= y.words_[i];
+    }
+    return *this;
+  }
+
+  constexpr UInt256& operator|=(const UInt256& y) {
+    for (unsigned i = 0; i < 4; ++i) {
+      words_[i] |= y.words_[i];
+    }
+    return *this;
+  }
+
+  // quotient & remainder; throws std::domain_error on division by zero
+  static std::pair<UInt256, UInt256> divmod(UInt256 x, const UInt256& y);
+
+  friend constexpr UInt256 operator+(UInt256 x, const UInt256& y) {
+    return x += y;
+  }
+  friend constexpr UInt256 operator-(UInt256 x, const UInt256& y) {
+    return x -= y;
+  }
+  friend constexpr UInt256 operator*(UInt256 x, const UInt256& y) {
+    return x *= y;
+  }
+  friend UInt256 operator/(const UInt256& x, const UInt256& y) {
+    return divmod(x, y).first;
+  }
+  friend UInt256 operator%(const UInt256& x, const UInt256& y) {
+    return divmod(x, y).second;
+  }
+  friend constexpr UInt256 operator<<(UInt256 x, unsigned n) {
+    return x <<= n;
+  }
+  friend constexpr UInt256 operator>>(UInt256 x, unsigned n) {
+    return x >>= n;
+  }
+  friend constexpr UInt256 operator&(UInt256 x, const UInt256& y) {
+    return x &= y;
+  }
+  friend constexpr UInt256 operator|(UInt256 x, const UInt256& y) {
+    return x |= y;
+  }
+
+  friend constexpr bool operator==(const UInt256& x, const UInt256& y) {
+    return ((x.words_[0] ^ y.words_[0]) | (x.words_[1] ^ y.words_[1]) |
+            (x.words_[2] ^ y.words_[2]) | (x.words_[3] ^ y.words_[3])) == 0;
+  }
+  friend constexpr bool operator!=(const UInt256& x, const UInt256& y) {
+    return !(x == y);
+  }
+  friend constexpr bool operator<(const UInt256& x, const UInt256& y) {
+    for (unsigned i = 4; i-- > 0;) {
+      if (x.words_[i] != y.words_[i]) {
+        return x.words_[i] < y.words_[i];
+      }
+    }
+    return false;
+  }
+  friend constexpr bool operator>(const UInt256& x, const UInt256& y) {
+    return y < x;
+  }
+  friend constexpr bool operator<=(const UInt256& x, const UInt256& y) {
+    return !(y < x);
+  }
+  friend constexpr bool operator>=(const UInt256& x, const UInt256& y) {
+    return !(x < y);
+  }
+
+ private:
+  uint64_t words_[4] = {};
+
+  // {low, high} words of x * y + a + b, which always fits
+  static constexpr std::pair<uint64_t, uint64_t> mul_add(uint64_t x,
+                                                         uint64_t y,
+                                                         uint64_t a,
+                                                         uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    const auto p = UInt128{x} * y + a + b;
+    return {static_cast<uint64_t>(p), static_cast<uint64_t>(p >> 64)};
+#else
+    const auto x0 = x & 0xffff'ffff, x1 = x >> 32;
+    const auto y0 = y & 0xffff'ffff, y1 = y >> 32;
+    const auto p00 = x0 * y0, p01 = x0 * y1, p10 = x1 * y0;
+    const auto mid = (p00 >> 32) + (p01 & 0xffff'ffff) + (p10 & 0xffff'ffff);
+    auto low = (mid << 32) | (p00 & 0xffff'ffff);
+    auto high = x1 * y1 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    low += a;
+    high += low < a;
+    low += b;
+    high += low < b;
+    return {low, high};
+#endif
+  }
+};
+
+// in decimal
+std::string to_string(const UInt256&);
+
+}  // namespace silkworm
+
+#endif  // SILKWORM_CORE_UINT256_HPP_
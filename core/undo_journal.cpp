@@ -0,0 +1,113 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "undo_journal.hpp"
+
+#include <stdexcept>
+
+namespace silkworm {
+
+void UndoJournal::record(const DbBucket& db, std::string_view key) {
+  const std::string k(key);
+  if (pending_.count(k)) {
+    return;
+  }
+  const auto val = db.get(key);
+  pending_.emplace(k, val ? std::optional<std::string>(*val) : std::nullopt);
+}
+
+void UndoJournal::seal(uint32_t block) {
+  if (base_ && block == latest_block()) {
+    if (!blocks_.empty()) {
+      // the previous values recorded earlier take precedence
+      blocks_.back().changes.merge(pending_);
+    }
+    pending_.clear();
+    return;
+  }
+
+  if (!base_ || block != latest_block() + 1) {
+    // nothing recorded so far leads up to the block
+    blocks_.clear();
+    pending_.clear();
+    base_ = block;
+    return;
+  }
+
+  blocks_.push_back(Block{block, std::move(pending_)});
+  pending_.clear();
+
+  while (blocks_.size() > max_blocks_) {
+    base_ = blocks_.front().number;
+    blocks_.pop_front();
+  }
+}
+
+uint32_t UndoJournal::latest_block() const {
+  return blocks_.empty() ? *base_ : blocks_.back().number;
+}
+
+std::map<std::string, std::optional<std::string>> UndoJournal::changes_since(
+    uint32_t block, std::string_view lower,
+    std::optional<std::string_view> upper) const {
+  Changes changes;
+  // the earliest change after the block has the value as of the block
+  for (const auto& b : blocks_) {
+    if (b.number <= block) {
+      continue;
+    }
+    const auto end =
+        upper ? b.changes.lower_bound(std::string(*upper)) : b.changes.end();
+    for (auto it = b.changes.lower_bound(std::string(lower)); it != end;
+         ++it) {
+      changes.insert(*it);
+    }
+  }
+  return changes;
+}
+
+std::vector<std::string> UndoJournal::unwind(DbBucket& db, uint32_t block) {
+  if (!base_ || block < *base_ || block > latest_block()) {
+    throw std::out_of_range("block not in the undo journal");
+  }
+
+  std::vector<std::string> keys;
+
+  undo(db, pending_, keys);
+  pending_.clear();
+
+  while (!blocks_.empty() && blocks_.back().number > block) {
+    undo(db, blocks_.back().changes, keys);
+    blocks_.pop_back();
+  }
+
+  return keys;
+}
+
+void UndoJournal::undo(DbBucket& db, const Changes& changes,
+                       std::vector<std::string>& keys) {
+  for (const auto& change : changes) {
+    const auto& key = change.first;
+    if (change.second) {
+      db.put(key, *change.second);
+    } else {
+      db.del(key, key + '\0');
+    }
+    keys.push_back(key);
+  }
+}
+
+}  // namespace silkworm
@@ -0,0 +1,83 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_UNDO_JOURNAL_HPP_
+#define SILKWORM_CORE_UNDO_JOURNAL_HPP_
+
+#include <deque>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "db_bucket.hpp"
+
+namespace silkworm {
+
+// Previous values of the entries changed in a bucket, kept per block for the
+// last few blocks so that the bucket can be rolled back, e.g. on a chain
+// reorg, in time proportional to the number of changes.
+class UndoJournal {
+ public:
+  explicit UndoJournal(uint32_t max_blocks) : max_blocks_(max_blocks) {}
+
+  // Must be called before the entry is overwritten or deleted.
+  // Only the first call per key and block has any effect.
+  void record(const DbBucket&, std::string_view key);
+
+  // Closes the changes recorded since the last seal as those of the block.
+  // Sealing the same block again adds to it. The first seal, and one
+  // skipping blocks, only sets the block to roll back to, dropping the
+  // changes, which can't be told apart by block.
+  void seal(uint32_t block);
+
+  // Oldest block that the bucket can be rolled back to, if any:
+  // the first block sealed, or the one sealed after a gap, until
+  // max_blocks newer ones push it forward.
+  std::optional<uint32_t> earliest_block() const { return base_; }
+
+  // Values as of the given block of the entries with lower <= key < upper
+  // changed by the blocks sealed after it; nullopt if the entry didn't exist.
+  std::map<std::string, std::optional<std::string>> changes_since(
+      uint32_t block, std::string_view lower,
+      std::optional<std::string_view> upper) const;
+
+  // Restores the bucket as of the given block, also undoing any changes
+  // not sealed yet. Returns the keys of the restored entries.
+  std::vector<std::string> unwind(DbBucket&, uint32_t block);
+
+ private:
+  // key -> previous value, nullopt if the entry didn't exist
+  using Changes = std::map<std::string, std::optional<std::string>>;
+
+  struct Block {
+    uint32_t number;
+    Changes changes;
+  };
+
+  uint32_t max_blocks_;
+  std::optional<uint32_t> base_;  // the block blocks_ start from
+  std::deque<Block> blocks_;
+  Changes pending_;
+
+  uint32_t latest_block() const;
+
+  static void undo(DbBucket&, const Changes&, std::vector<std::string>& keys);
+};
+
+}  // namespace silkworm
+
+#endif  // SILKWORM_CORE_UNDO_JOURNAL_HPP_
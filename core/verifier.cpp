@@ -0,0 +1,309 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "verifier.hpp"
+
+#include "keccak.hpp"
+#include "mptrie.hpp"
+
+namespace {
+
+using namespace silkworm;
+
+Nibble nibble_at(const Hash& key, uint8_t pos) {
+  return pos % 2 == 0 ? key[pos / 2] >> 4 : key[pos / 2] & 0xf;
+}
+
+template <class Leaves>
+Hash hash_range(uint8_t level, uint8_t depth, const Leaves& leaves,
+                const std::vector<Hash>& leaf_hashes, size_t begin,
+                size_t end);
+
+// Leaves is std::vector<sync::Leaf> or sync::LeafBatch.
+template <class Leaves>
+sync::Proof node_range(uint8_t level, uint8_t depth, const Leaves& leaves,
+                       const std::vector<Hash>& leaf_hashes, size_t begin,
+                       size_t end) {
+  sync::Proof node{};
+
+  while (begin != end) {
+    const auto nibble = nibble_at(leaves[begin].first, level);
+    auto group_end = begin + 1;
+    while (group_end != end &&
+           nibble_at(leaves[group_end].first, level) == nibble) {
+      ++group_end;
+    }
+
+    node.empty[nibble] = false;
+    if (level + 1 == depth) {
+      LeafHasher hasher;
+      for (auto i = begin; i != group_end; ++i) {
+        hasher.append_hash(leaf_hashes[i]);
+      }
+      node.hash[nibble] = hasher.hash();
+    } else {
+      node.hash[nibble] =
+          hash_range(level + 1, depth, leaves, leaf_hashes, begin, group_end);
+    }
+
+    begin = group_end;
+  }
+
+  return node;
+}
+
+template <class Leaves>
+Hash hash_range(uint8_t level, uint8_t depth, const Leaves& leaves,
+                const std::vector<Hash>& leaf_hashes, size_t begin,
+                size_t end) {
+  const auto node = node_range(level, depth, leaves, leaf_hashes, begin, end);
+  return mptrie::branch_node_hash(node.empty, node.hash);
+}
+
+template <class Leaves>
+std::vector<Hash> hash_values(const Leaves& leaves) {
+  std::vector<std::string_view> values;
+  values.reserve(leaves.size());
+  for (const auto& leaf : leaves) {
+    values.push_back(leaf.second);
+  }
+
+  std::vector<Hash> hashes(leaves.size());
+  keccak(values.data(), hashes.data(), values.size());
+  return hashes;
+}
+
+}  // namespace
+
+namespace silkworm::sync {
+
+std::vector<Hash> hash_leaves(const std::vector<Leaf>& leaves) {
+  return hash_values(leaves);
+}
+
+std::vector<Hash> hash_leaves(const LeafBatch& leaves) {
+  return hash_values(leaves);
+}
+
+Hash subtree_hash(uint8_t level, uint8_t depth,
+                  const std::vector<Leaf>& leaves,
+                  const std::vector<Hash>& leaf_hashes) {
+  return hash_range(level, depth, leaves, leaf_hashes, 0, leaves.size());
+}
+
+Hash subtree_hash(uint8_t level, uint8_t depth, const LeafBatch& leaves,
+                  const std::vector<Hash>& leaf_hashes) {
+  return hash_range(level, depth, leaves, leaf_hashes, 0, leaves.size());
+}
+
+Proof subtree_node(uint8_t level, uint8_t depth,
+                   const std::vector<Leaf>& leaves,
+                   const std::vector<Hash>& leaf_hashes) {
+  return node_range(level, depth, leaves, leaf_hashes, 0, leaves.size());
+}
+
+Verdict verify(const GetLeavesRequest& request, const LeavesReply& reply,
+               uint8_t depth) {
+  Verdict verdict;
+  if (reply.status != LeavesReply::kOK) {
+    return verdict;
+  }
+
+  const auto prefix = request.prefix;
+  if (prefix.size() == 0 || prefix.size() > depth) {
+    verdict.error = "unsupported prefix size";
+    return verdict;
+  }
+
+  const bool same_block = request.block_number &&
+                          *request.block_number == reply.block_number;
+  if (request.block_number && reply.block_number < *request.block_number) {
+    verdict.error = "older block than requested";
+    return verdict;
+  }
+  if (reply.proof.size() > prefix.size() ||
+      (!same_block && reply.proof.size() != prefix.size())) {
+    verdict.error = "wrong proof size";
+    return verdict;
+  }
+  // otherwise the proof alone would mark the subtree synced without
+  // its leaves
+  if (!reply.leaves && !request.hash) {
+    verdict.error = "leaves left out unasked";
+    return verdict;
+  }
+  if (!reply.leaves && reply.proof.empty()) {
+    verdict.error = "neither leaves nor proof";
+    return verdict;
+  }
+
+  // hash of the node right below the current one
+  bool below_empty = true;
+  Hash below_hash{};
+
+  if (reply.leaves) {
+    const auto& leaves = *reply.leaves;
+    for (size_t i = 0; i < leaves.size(); ++i) {
+      if (!prefix.matches(leaves[i].first)) {
+        verdict.error = "leaf doesn't match the prefix";
+        return verdict;
+      }
+      if (i > 0 && !(leaves[i - 1].first < leaves[i].first)) {
+        verdict.error = "leaves not strictly ordered";
+        return verdict;
+      }
+    }
+
+    verdict.leaf_hashes = hash_leaves(leaves);
+
+    below_empty = leaves.empty();
+    if (!below_empty && prefix.size() == depth) {
+      LeafHasher hasher;
+      for (const auto& h : verdict.leaf_hashes) {
+        hasher.append_hash(h);
+      }
+      below_hash = hasher.hash();
+    } else if (!below_empty) {
+      below_hash =
+          subtree_hash(prefix.size(), depth, leaves, verdict.leaf_hashes);
+    }
+  } else if (request.hash) {
+    // left out as the requester has them already
+    below_empty = false;
+    below_hash = *request.hash;
+  }
+
+  const auto start_from =
+      static_cast<uint8_t>(prefix.size() - reply.proof.size());
+  for (size_t i = reply.proof.size(); i-- > 0;) {
+    const auto& node = reply.proof[i];
+    const auto nibble = prefix[static_cast<uint8_t>(start_from + i)];
+
+    if (node.empty[nibble] != below_empty ||
+        (!below_empty && node.hash[nibble] != below_hash)) {
+      verdict.error = "proof doesn't match";
+      return verdict;
+    }
+
+    below_empty = node.empty.all();
+    if (!below_empty) {
+      below_hash = mptrie::branch_node_hash(node.empty, node.hash);
+    }
+  }
+
+  verdict.top_empty = below_empty;
+  verdict.top_hash = below_hash;
+  return verdict;
+}
+
+Verdict verify(const GetStorageRequest& request, const StorageReply& reply) {
+  Verdict verdict;
+  if (reply.storage.size() != request.accounts.size()) {
+    verdict.error = "wrong number of tries";
+    return verdict;
+  }
+
+  // the leaves are checked against the storage roots when applied
+  for (const auto& storage : reply.storage) {
+    const auto& leaves = storage.leaves;
+    for (size_t i = 1; i < leaves.size(); ++i) {
+      if (!(leaves[i - 1].first < leaves[i].first)) {
+        verdict.error = "leaves not strictly ordered";
+        return verdict;
+      }
+    }
+  }
+  return verdict;
+}
+
+Verdict verify(const Request& request, const Reply& reply, uint8_t depth) {
+  Verdict mismatch;
+  mismatch.error = "unexpected reply type";
+
+  if (const auto leaves_request = std::get_if<GetLeavesRequest>(&request)) {
+    const auto leaves_reply = std::get_if<LeavesReply>(&reply);
+    if (!leaves_reply) {
+      return mismatch;
+    }
+    return verify(*leaves_request, *leaves_reply,
+                  leaves_request->account ? kStorageTrieDepth : depth);
+  } else if (const auto storage_request =
+                 std::get_if<GetStorageRequest>(&request)) {
+    const auto storage_reply = std::get_if<StorageReply>(&reply);
+    if (!storage_reply) {
+      return mismatch;
+    }
+    return verify(*storage_request, *storage_reply);
+  } else if (std::holds_alternative<GetNodeRequest>(request) &&
+             !std::holds_alternative<NodeReply>(reply)) {
+    return mismatch;
+  }
+  return {};
+}
+
+Verifier::Verifier(unsigned num_threads) {
+  for (unsigned i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(&Verifier::work, this);
+  }
+}
+
+Verifier::~Verifier() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+std::future<Verdict> Verifier::submit(const Request& request,
+                                      const Reply& reply, uint8_t depth) {
+  std::packaged_task<Verdict()> task(
+      [&request, &reply, depth] { return verify(request, reply, depth); });
+  auto future = task.get_future();
+
+  if (threads_.empty()) {
+    task();
+    return future;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+  return future;
+}
+
+void Verifier::work() {
+  while (true) {
+    std::packaged_task<Verdict()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;  // stopping
+      }
+      task = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    task();
+  }
+}
+
+}  // namespace silkworm::sync
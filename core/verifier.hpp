@@ -0,0 +1,102 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_CORE_VERIFIER_HPP_
+#define SILKWORM_CORE_VERIFIER_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sync.hpp"
+
+// Checks of sync replies that don't depend on the leecher's tree, so that
+// they can run on other threads while earlier replies are being applied.
+// What's left for the apply stage is matching the top of the proof
+// against the tree (see State::process_leaves_reply).
+
+namespace silkworm::sync {
+
+struct Verdict {
+  std::string error;  // empty if the reply passed
+
+  // keccak of each leaf value, in the order of the leaves
+  std::vector<Hash> leaf_hashes;
+
+  // the topmost node the reply proves: empty or with this hash
+  bool top_empty = true;
+  Hash top_hash{};
+
+  bool ok() const { return error.empty(); }
+};
+
+// Checks that the leaves are strictly ordered and match the prefix,
+// and that they hash up through the proof; request.hash does if they
+// were left out.
+Verdict verify(const GetLeavesRequest&, const LeavesReply&, uint8_t depth);
+
+// Checks that the leaves of every trie are strictly ordered.
+Verdict verify(const GetStorageRequest&, const StorageReply&);
+
+// depth is that of the state trie; node replies pass as they are.
+Verdict verify(const Request&, const Reply&, uint8_t depth);
+
+std::vector<Hash> hash_leaves(const std::vector<Leaf>&);
+std::vector<Hash> hash_leaves(const LeafBatch&);
+
+// Hash of the node at the given level above leaves sharing its prefix,
+// which must be strictly ordered. leaf_hashes as per hash_leaves.
+Hash subtree_hash(uint8_t level, uint8_t depth,
+                  const std::vector<Leaf>& leaves,
+                  const std::vector<Hash>& leaf_hashes);
+Hash subtree_hash(uint8_t level, uint8_t depth, const LeafBatch& leaves,
+                  const std::vector<Hash>& leaf_hashes);
+
+// The node itself rather than its hash.
+Proof subtree_node(uint8_t level, uint8_t depth,
+                   const std::vector<Leaf>& leaves,
+                   const std::vector<Hash>& leaf_hashes);
+
+// Runs verify on a pool of worker threads.
+class Verifier {
+ public:
+  explicit Verifier(unsigned num_threads);
+  ~Verifier();
+
+  Verifier(const Verifier&) = delete;
+  Verifier& operator=(const Verifier&) = delete;
+
+  // The request and the reply must stay alive until the future is ready.
+  std::future<Verdict> submit(const Request&, const Reply&, uint8_t depth);
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::packaged_task<Verdict()>> queue_;
+  bool stopping_ = false;
+
+  std::vector<std::thread> threads_;
+
+  void work();
+};
+
+}  // namespace silkworm::sync
+
+#endif  // SILKWORM_CORE_VERIFIER_HPP_
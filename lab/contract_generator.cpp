@@ -0,0 +1,53 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "contract_generator.hpp"
+
+#include <cmath>
+
+namespace silkworm::lab {
+
+size_t ContractGenerator::random_storage_size() {
+  static constexpr double kShape = 0.8;
+  std::uniform_real_distribution<double> uniform(0, 1);
+
+  const double size = 1 / std::pow(1 - uniform(rng_), 1 / kShape);
+  return size >= kMaxStorageSize ? kMaxStorageSize : static_cast<size_t>(size);
+}
+
+Hash ContractGenerator::random_location() {
+  std::uniform_int_distribution<uint32_t> byte_dist(0, 0xff);
+
+  Hash location;
+  for (auto& x : location) {
+    x = byte_dist(rng_);
+  }
+  return location;
+}
+
+std::string ContractGenerator::random_value() {
+  std::uniform_int_distribution<uint32_t> len_dist(1, kHashBytes);
+  std::uniform_int_distribution<uint32_t> byte_dist(0, 0xff);
+
+  std::string value(len_dist(rng_), '\0');
+  value[0] = std::uniform_int_distribution<uint32_t>(1, 0xff)(rng_);
+  for (size_t i = 1; i < value.size(); ++i) {
+    value[i] = byte_dist(rng_);
+  }
+  return value;
+}
+
+}  // namespace silkworm::lab
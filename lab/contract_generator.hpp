@@ -0,0 +1,45 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_LAB_CONTRACT_GENERATOR_HPP_
+#define SILKWORM_LAB_CONTRACT_GENERATOR_HPP_
+
+#include "dust_generator.hpp"
+
+namespace silkworm::lab {
+
+class ContractGenerator {
+ public:
+  static constexpr size_t kMaxStorageSize = 100'000;
+
+  explicit ContractGenerator(RNG& rng) : rng_(rng) {}
+
+  // Pareto distributed: most contracts have a handful of storage locations,
+  // a few have a lot.
+  size_t random_storage_size();
+
+  Hash random_location();
+
+  // up to 32 bytes without leading zeros
+  std::string random_value();
+
+ private:
+  RNG& rng_;
+};
+
+}  // namespace silkworm::lab
+
+#endif  // SILKWORM_LAB_CONTRACT_GENERATOR_HPP_
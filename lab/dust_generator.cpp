@@ -16,6 +16,63 @@
 
 #include "dust_generator.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "keccak.hpp"
+#include "sync.hpp"
+
+namespace {
+
+using namespace silkworm;
+
+// accounts generated & sorted at a time by a thread
+constexpr uint64_t kChunkSize = 1 << 20;
+
+// https://prng.di.unimi.it/splitmix64.c
+uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+  return x ^ (x >> 31);
+}
+
+// k-th random word of account number index
+uint64_t random_word(uint64_t seed, uint64_t index, unsigned k) {
+  return splitmix64(splitmix64(seed) ^ (index * 4 + k));
+}
+
+std::vector<sync::Leaf> generate_chunk(uint64_t seed, uint64_t begin,
+                                       uint64_t end) {
+  std::vector<Address> addresses;
+  addresses.reserve(end - begin);
+  for (auto i = begin; i < end; ++i) {
+    addresses.push_back(lab::dust_address(seed, i));
+  }
+
+  std::vector<std::string_view> views;
+  views.reserve(addresses.size());
+  for (const auto& address : addresses) {
+    views.push_back(byte_view(address));
+  }
+  std::vector<Hash> keys(addresses.size());
+  keccak(views.data(), keys.data(), views.size());
+
+  std::vector<sync::Leaf> leaves;
+  leaves.reserve(addresses.size());
+  for (auto i = begin; i < end; ++i) {
+    leaves.emplace_back(keys[i - begin], to_rlp(lab::dust_account(seed, i)));
+  }
+  std::sort(leaves.begin(), leaves.end());
+  return leaves;
+}
+
+}  // namespace
+
 namespace silkworm::lab {
 
 Address DustGenerator::random_address() {
@@ -40,4 +97,79 @@ Account DustGenerator::random_account() {
   account.balance = balance_dist(rng_);
   return account;
 }
+
+Address dust_address(uint64_t seed, uint64_t index) {
+  static_assert(kAddressBytes <= 3 * 8);
+
+  Address address;
+  for (size_t j = 0; j < kAddressBytes; ++j) {
+    const auto word = random_word(seed, index, j / 8);
+    address[j] = (word >> (j % 8 * 8)) & 0xff;
+  }
+  return address;
+}
+
+Account dust_account(uint64_t seed, uint64_t index) {
+  Account account;
+  account.balance = 1 + random_word(seed, index, 3) % kFinney;
+  return account;
+}
+
+void generate_dust(DbBucket& db, uint64_t seed, uint64_t num_accounts,
+                   unsigned num_threads) {
+  const auto num_chunks = (num_accounts + kChunkSize - 1) / kChunkSize;
+  std::vector<std::vector<sync::Leaf>> chunks(num_chunks);
+
+  std::atomic<uint64_t> next_chunk{0};
+  const auto work = [&] {
+    for (auto i = next_chunk++; i < num_chunks; i = next_chunk++) {
+      const auto begin = i * kChunkSize;
+      const auto end = std::min(begin + kChunkSize, num_accounts);
+      chunks[i] = generate_chunk(seed, begin, end);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < num_threads; ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // merge the sorted chunks, freeing each once it's been put
+  using Cursor = std::pair<std::vector<sync::Leaf>::iterator, size_t>;
+  const auto greater = [](const Cursor& a, const Cursor& b) {
+    return b.first->first < a.first->first;
+  };
+  std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(
+      greater);
+  for (size_t i = 0; i < num_chunks; ++i) {
+    if (!chunks[i].empty()) {
+      heap.emplace(chunks[i].begin(), i);
+    }
+  }
+
+  // the last leaf of a chunk is viewed until the next call
+  std::optional<size_t> exhausted;
+  db.put([&heap, &chunks, &exhausted]() -> std::optional<DbBucket::KeyVal> {
+    if (exhausted) {
+      std::vector<sync::Leaf>().swap(chunks[*exhausted]);
+      exhausted.reset();
+    }
+    if (heap.empty()) {
+      return {};
+    }
+    auto [it, i] = heap.top();
+    heap.pop();
+    if (std::next(it) != chunks[i].end()) {
+      heap.emplace(std::next(it), i);
+    } else {
+      exhausted = i;
+    }
+    return DbBucket::KeyVal{byte_view(it->first), it->second};
+  });
+}
+
 }  // namespace silkworm::lab
@@ -20,6 +20,7 @@
 #include <random>
 
 #include "account.hpp"
+#include "db_bucket.hpp"
 
 namespace silkworm::lab {
 
@@ -36,6 +37,18 @@ class DustGenerator {
   RNG& rng_;
 };
 
+// Dust account number index of the sequence given by the seed.
+// Unlike DustGenerator, any part of the sequence can be generated
+// independently of the rest.
+Address dust_address(uint64_t seed, uint64_t index);
+Account dust_account(uint64_t seed, uint64_t index);
+
+// Puts the first num_accounts accounts of the sequence into the db, keyed
+// by keccak of the address, in ascending order of keys. The result doesn't
+// depend on the number of threads.
+void generate_dust(DbBucket&, uint64_t seed, uint64_t num_accounts,
+                   unsigned num_threads);
+
 }  // namespace silkworm::lab
 
 #endif  // SILKWORM_LAB_DUST_GENERATOR_HPP_
@@ -0,0 +1,144 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "network.hpp"
+
+#include <future>
+#include <memory>
+#include <stdexcept>
+
+namespace silkworm::lab {
+
+void EventLoop::schedule(double time, std::function<void()> event) {
+  if (time < now_) {
+    throw std::invalid_argument("cannot schedule events in the past");
+  }
+  queue_.push(Event{time, seq_++, std::move(event)});
+}
+
+void EventLoop::run_until(double time) {
+  while (!queue_.empty() && queue_.top().time <= time) {
+    // the event may schedule new ones, so take it off the queue first
+    auto event = queue_.top();
+    queue_.pop();
+    now_ = event.time;
+    event.fn();
+  }
+  now_ = std::max(now_, time);
+}
+
+Link::Link(EventLoop& loop, const LinkModel& model, RNG& rng)
+    : loop_(loop), model_(model), rng_(rng) {
+  if (model.bandwidth <= 0 || model.mtu == 0) {
+    throw std::invalid_argument("bandwidth and MTU must be positive");
+  }
+  if (model.loss < 0 || model.loss >= 1) {
+    throw std::invalid_argument("packet loss must be in [0, 1)");
+  }
+}
+
+void Link::send(size_t bytes, std::function<void()> on_delivery) {
+  const uint64_t num_packets =
+      std::max<uint64_t>(1, (bytes + model_.mtu - 1) / model_.mtu);
+
+  std::bernoulli_distribution packet_lost(model_.loss);
+  uint64_t num_lost = 0;
+  for (uint64_t i = 0; i < num_packets; ++i) {
+    while (packet_lost(rng_)) {
+      ++num_lost;
+    }
+  }
+
+  const double wire_bytes = bytes + num_lost * model_.mtu;
+  busy_until_ =
+      std::max(loop_.now(), busy_until_) + wire_bytes / model_.bandwidth;
+
+  double latency = model_.latency;
+  if (model_.jitter > 0) {
+    std::normal_distribution<double> jitter(0, model_.jitter);
+    latency = std::max(0.0, latency + jitter(rng_));
+  }
+
+  // TCP delivers in order, so a late message holds back the ones behind it
+  const double arrival = std::max(
+      busy_until_ + latency + num_lost * model_.rto(), last_arrival_);
+  last_arrival_ = arrival;
+
+  bytes_sent_ += bytes;
+  packets_sent_ += num_packets + num_lost;
+  packets_lost_ += num_lost;
+
+  loop_.schedule(arrival, std::move(on_delivery));
+}
+
+void SyncSession::drain(std::function<void()> on_idle) {
+  on_idle_ = std::move(on_idle);
+  pump();
+}
+
+void SyncSession::pause(std::function<void()> on_idle) {
+  paused_ = true;
+  drain(std::move(on_idle));
+}
+
+void SyncSession::resume() {
+  paused_ = false;
+  pump();
+}
+
+void SyncSession::pump() {
+  if (on_idle_) {
+    if (in_flight_ != 0) {
+      return;
+    }
+    const auto on_idle = std::move(on_idle_);
+    on_idle_ = nullptr;
+    on_idle();
+  }
+  if (paused_) {
+    return;
+  }
+
+  while (in_flight_ < max_in_flight_) {
+    auto request =
+        std::make_shared<const sync::Request>(leecher_.next_sync_request());
+    if (std::holds_alternative<std::monostate>(*request)) {
+      return;
+    }
+
+    ++in_flight_;
+
+    uplink_.send(sync::byte_size(*request), [this, request] {
+      auto reply =
+          std::make_shared<const sync::Reply>(seeder_.reply_to(*request));
+
+      downlink_.send(sync::byte_size(*reply), [this, request, reply] {
+        // Applied right after at the same virtual time, while the replies
+        // delivered meanwhile are being verified.
+        auto verdict = std::make_shared<std::future<sync::Verdict>>(
+            leecher_.verify_reply(*request, *reply));
+        loop_.schedule(loop_.now(), [this, request, reply, verdict] {
+          --in_flight_;
+          leecher_.apply_reply(*request, *reply, std::move(*verdict), stats_);
+          last_reply_time_ = loop_.now();
+          pump();
+        });
+      });
+    });
+  }
+}
+
+}  // namespace silkworm::lab
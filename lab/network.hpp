@@ -0,0 +1,148 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_LAB_NETWORK_HPP_
+#define SILKWORM_LAB_NETWORK_HPP_
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "dust_generator.hpp"
+#include "node.hpp"
+
+// Discrete-event network model for the sync emulator.
+// All times are virtual and measured in seconds.
+
+namespace silkworm::lab {
+
+class EventLoop {
+ public:
+  double now() const { return now_; }
+
+  void schedule(double time, std::function<void()> event);
+
+  // Runs all events due no later than the given time
+  // and then advances the clock to it.
+  void run_until(double time);
+
+ private:
+  struct Event {
+    double time;
+    uint64_t seq;  // keeps simultaneous events in FIFO order
+    std::function<void()> fn;
+
+    friend bool operator>(const Event& a, const Event& b) {
+      return a.time > b.time || (a.time == b.time && a.seq > b.seq);
+    }
+  };
+
+  double now_ = 0;
+  uint64_t seq_ = 0;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> queue_;
+};
+
+struct LinkModel {
+  double latency = 0.05;             // one way
+  double jitter = 0.01;              // standard deviation of the latency
+  double bandwidth = 1'000'000 / 8;  // bytes per sec
+  double loss = 0.001;               // packet loss probability
+  unsigned mtu = 1500;               // bytes per packet
+
+  // TCP-like retransmission timeout
+  double rto() const { return std::max(0.2, 4 * latency); }
+};
+
+// One direction of a TCP-like connection. Messages are serialized at the
+// link bandwidth and delivered in order; every lost packet is retransmitted
+// after a timeout, delaying its message and the ones queued behind it.
+class Link {
+ public:
+  Link(EventLoop& loop, const LinkModel& model, RNG& rng);
+
+  void send(size_t bytes, std::function<void()> on_delivery);
+
+  uint64_t bytes_sent() const { return bytes_sent_; }
+  uint64_t packets_sent() const { return packets_sent_; }
+  uint64_t packets_lost() const { return packets_lost_; }
+
+ private:
+  EventLoop& loop_;
+  LinkModel model_;
+  RNG& rng_;
+
+  double busy_until_ = 0;    // sender side
+  double last_arrival_ = 0;  // receiver side
+
+  uint64_t bytes_sent_ = 0;
+  uint64_t packets_sent_ = 0;
+  uint64_t packets_lost_ = 0;
+};
+
+// Drives the sync of a leecher against a seeder over a pair of links,
+// keeping up to max_in_flight requests outstanding.
+// The seeder replies with its state as of the time the request arrives.
+class SyncSession {
+ public:
+  SyncSession(EventLoop& loop, Node& leecher, const Node& seeder,
+              Link& uplink, Link& downlink, unsigned max_in_flight,
+              sync::Stats& stats)
+      : loop_(loop),
+        leecher_(leecher),
+        seeder_(seeder),
+        uplink_(uplink),
+        downlink_(downlink),
+        max_in_flight_(max_in_flight),
+        stats_(stats) {}
+
+  // Sends new requests while there is room in the pipeline.
+  // Call it again whenever the seeder gets a new block.
+  void pump();
+
+  // Stops sending new requests and calls on_idle once all replies are in,
+  // e.g. to restructure the nodes between sync phases. Resumes afterwards.
+  void drain(std::function<void()> on_idle);
+
+  // Like drain, but stays idle after on_idle until resume, e.g. to wait for
+  // the other sessions with the same seeder.
+  void pause(std::function<void()> on_idle);
+  void resume();
+
+  unsigned in_flight() const { return in_flight_; }
+
+  // virtual time when the last reply was processed
+  double last_reply_time() const { return last_reply_time_; }
+
+ private:
+  EventLoop& loop_;
+  Node& leecher_;
+  const Node& seeder_;
+  Link& uplink_;
+  Link& downlink_;
+  const unsigned max_in_flight_;
+  sync::Stats& stats_;
+
+  unsigned in_flight_ = 0;
+  double last_reply_time_ = 0;
+  bool paused_ = false;
+
+  std::function<void()> on_idle_;
+};
+
+}  // namespace silkworm::lab
+
+#endif  // SILKWORM_LAB_NETWORK_HPP_
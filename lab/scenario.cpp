@@ -0,0 +1,322 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "scenario.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+using namespace silkworm;
+using namespace silkworm::lab;
+
+std::string_view trim(std::string_view s) {
+  const auto begin = s.find_first_not_of(" \t\r");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  const auto end = s.find_last_not_of(" \t\r");
+  return s.substr(begin, end - begin + 1);
+}
+
+[[noreturn]] void bad_value(std::string_view value) {
+  throw std::invalid_argument("bad value '" + std::string(value) + "'");
+}
+
+std::string without_separators(std::string_view number) {
+  std::string res;
+  for (const char c : number) {
+    if (c != '\'' && c != '_') {
+      res += c;
+    }
+  }
+  return res;
+}
+
+template <class T>
+void parse(std::string_view text, T& out) {
+  static_assert(std::is_unsigned_v<T>);
+
+  const auto digits = without_separators(text);
+  uint64_t x = 0;
+  const auto end = digits.data() + digits.size();
+  const auto res = std::from_chars(digits.data(), end, x);
+  if (digits.empty() || res.ec != std::errc{} || res.ptr != end ||
+      x > std::numeric_limits<T>::max()) {
+    bad_value(text);
+  }
+  out = static_cast<T>(x);
+}
+
+void parse(std::string_view text, double& out) {
+  const auto s = without_separators(text);
+  size_t pos = 0;
+  try {
+    out = std::stod(s, &pos);
+  } catch (const std::logic_error&) {
+    bad_value(text);
+  }
+  if (pos != s.size()) {
+    bad_value(text);
+  }
+}
+
+void parse(std::string_view text, bool& out) {
+  if (text == "true" || text == "1") {
+    out = true;
+  } else if (text == "false" || text == "0") {
+    out = false;
+  } else {
+    bad_value(text);
+  }
+}
+
+void parse(std::string_view text, std::string& out) { out = text; }
+
+void parse(std::string_view text, Backend& out) {
+  if (text == "mem") {
+    out = Backend::kMem;
+  } else if (text == "lmdb") {
+    out = Backend::kLmdb;
+  } else {
+    bad_value(text);
+  }
+}
+
+template <class T>
+void parse(std::string_view text, std::optional<T>& out) {
+  if (text.empty()) {
+    out.reset();
+  } else {
+    out.emplace();
+    parse(text, *out);
+  }
+}
+
+template <class T>
+std::string format(const T& x) {
+  return std::to_string(x);
+}
+
+std::string format(double x) {
+  std::ostringstream out;
+  out << x;
+  return out.str();
+}
+
+std::string format(bool x) { return x ? "true" : "false"; }
+
+std::string format(const std::string& x) { return x; }
+
+std::string format(Backend x) { return x == Backend::kMem ? "mem" : "lmdb"; }
+
+template <class T>
+std::string format(const std::optional<T>& x) {
+  return x ? format(*x) : "";
+}
+
+struct Param {
+  const char* name;
+  const char* description;
+  std::function<void(Scenario&, std::string_view)> set;
+  std::function<std::string(Scenario)> get;
+};
+
+// the path of member pointers leads from Scenario to the parameter
+template <class... Members>
+Param param(const char* name, const char* description, Members... path) {
+  return {name, description,
+          [path...](Scenario& s, std::string_view text) {
+            parse(text, (s.*....*path));
+          },
+          [path...](Scenario s) { return format((s.*....*path)); }};
+}
+
+const std::vector<Param>& params() {
+  using sync::Hints;
+  static const std::vector<Param> kParams = {
+      param("name", "in the results", &Scenario::name),
+      param("seed", "of all random generators", &Scenario::seed),
+      param("start_block", "of the initial state", &Scenario::start_block),
+      param("initial_accounts", "dust", &Scenario::initial_accounts),
+      param("initial_contracts", "accounts with storage",
+            &Scenario::initial_contracts),
+      param("block_time", "sec", &Scenario::block_time),
+      param("new_accounts", "per block", &Scenario::new_accounts),
+      param("updated_accounts", "per block", &Scenario::updated_accounts),
+      param("deleted_accounts", "per block", &Scenario::deleted_accounts),
+      param("reorg_probability", "per block", &Scenario::reorg_probability),
+      param("max_reorg_depth", "blocks", &Scenario::max_reorg_depth),
+      param("max_blocks", "to sync within; 0 for no limit",
+            &Scenario::max_blocks),
+      param("num_leechers", "syncing at once", &Scenario::num_leechers),
+      param("backend", "of the leechers' buckets: mem or lmdb",
+            &Scenario::backend),
+      param("max_requests_in_flight", "per leecher",
+            &Scenario::max_requests_in_flight),
+      param("verify_replies", "true or false", &Scenario::verify_replies),
+      param("verifier_threads", "per leecher; 0 verifies inline",
+            &Scenario::verifier_threads),
+      param("retune", "hints once phase 1 is done", &Scenario::retune),
+      param("hints.max_memory", "bytes", &Scenario::hints, &Hints::max_memory),
+      param("hints.approx_max_reply_size", "bytes", &Scenario::hints,
+            &Hints::approx_max_reply_size),
+      param("hints.node_size", "bytes", &Scenario::hints, &Hints::node_size),
+      param("hints.leaf_size", "bytes", &Scenario::hints, &Hints::leaf_size),
+      param("hints.num_leaves", "initial_accounts if empty",
+            &Scenario::hinted_num_leaves),
+      param("hints.changes_per_block", "accounts changed if empty",
+            &Scenario::hinted_changes_per_block),
+      param("seeder_max_memory", "bytes; hints.max_memory if empty",
+            &Scenario::seeder_max_memory),
+      param("link.latency", "sec, one way", &Scenario::link,
+            &LinkModel::latency),
+      param("link.jitter", "sec", &Scenario::link, &LinkModel::jitter),
+      param("link.bandwidth", "bytes per sec", &Scenario::link,
+            &LinkModel::bandwidth),
+      param("link.loss", "packet loss probability", &Scenario::link,
+            &LinkModel::loss),
+      param("link.mtu", "bytes per packet", &Scenario::link, &LinkModel::mtu),
+      param("trace_file", "of the first leecher", &Scenario::trace_file),
+  };
+  return kParams;
+}
+
+void write_csv_field(std::ostream& out, const std::string& field) {
+  if (field.find_first_of(",\"\n") == std::string::npos) {
+    out << field;
+    return;
+  }
+  out << '"';
+  for (const char c : field) {
+    if (c == '"') {
+      out << '"';
+    }
+    out << c;
+  }
+  out << '"';
+}
+
+}  // namespace
+
+namespace silkworm::lab {
+
+sync::Hints Scenario::initial_hints() const {
+  auto res = hints;
+  res.num_leaves = hinted_num_leaves.value_or(initial_accounts);
+  res.changes_per_block = hinted_changes_per_block.value_or(
+      new_accounts + updated_accounts + deleted_accounts);
+  return res;
+}
+
+void set_param(Scenario& scenario, std::string_view name,
+               std::string_view value) {
+  for (const auto& p : params()) {
+    if (name == p.name) {
+      p.set(scenario, trim(value));
+      return;
+    }
+  }
+  throw std::invalid_argument("unknown parameter '" + std::string(name) +
+                              "'");
+}
+
+void print_params(std::ostream& out, const Scenario& scenario) {
+  for (const auto& p : params()) {
+    out << "  " << std::left << std::setw(30) << p.name << std::setw(12)
+        << p.get(scenario) << p.description << '\n';
+  }
+  out << std::right;
+}
+
+std::vector<Scenario> read_scenarios(std::istream& in, const Scenario& base) {
+  auto common = base;
+  std::vector<Scenario> res;
+  std::string line;
+  for (unsigned line_number = 1; std::getline(in, line); ++line_number) {
+    const auto text = trim(std::string_view(line).substr(
+        0, std::min(line.size(), line.find('#'))));
+    if (text.empty()) {
+      continue;
+    }
+    try {
+      if (text.front() == '[' && text.back() == ']') {
+        res.push_back(common);
+        res.back().name = trim(text.substr(1, text.size() - 2));
+        continue;
+      }
+      const auto eq = text.find('=');
+      if (eq == std::string_view::npos) {
+        throw std::invalid_argument("expected name = value");
+      }
+      auto& scenario = res.empty() ? common : res.back();
+      set_param(scenario, trim(text.substr(0, eq)), text.substr(eq + 1));
+    } catch (const std::invalid_argument& e) {
+      throw std::invalid_argument("line " + std::to_string(line_number) +
+                                  ": " + e.what());
+    }
+  }
+  if (res.empty()) {
+    res.push_back(common);
+  }
+  return res;
+}
+
+double Result::reply_overhead() const {
+  const auto leaf_bytes = static_cast<double>(
+      (generated_leaves + generated_storage_leaves) * sync::kLeafSize);
+  return stats.reply_total_bytes / leaf_bytes - 1;
+}
+
+void write_csv_header(std::ostream& out) {
+  for (const auto& p : params()) {
+    out << p.name << ',';
+  }
+  out << "leecher,synced,verified,emulated_time,cpu_time,new_blocks,reorgs,"
+         "orphaned_blocks,generated_leaves,generated_storage_leaves,"
+         "requests,request_bytes,replies,rejected_replies,reply_bytes,"
+         "reply_leaves,reply_nodes,storage_leaves,packets_sent,"
+         "packets_lost,reply_overhead\n";
+}
+
+void write_csv_row(std::ostream& out, const Scenario& scenario,
+                   const Result& result) {
+  for (const auto& p : params()) {
+    write_csv_field(out, p.get(scenario));
+    out << ',';
+  }
+  const auto& stats = result.stats;
+  out << result.leecher << ',' << format(result.synced) << ','
+      << format(result.verified) << ','
+      << result.emulated_time << ',' << result.cpu_time << ','
+      << result.new_blocks << ',' << result.num_reorgs << ','
+      << result.orphaned_blocks << ',' << result.generated_leaves << ','
+      << result.generated_storage_leaves << ',' << stats.num_requests << ','
+      << stats.request_total_bytes << ',' << stats.num_replies << ','
+      << stats.num_rejected_replies << ',' << stats.reply_total_bytes << ','
+      << stats.reply_total_leaves << ',' << stats.reply_total_nodes << ','
+      << stats.reply_total_storage_leaves << ',' << result.packets_sent << ','
+      << result.packets_lost << ',' << result.reply_overhead() << '\n';
+}
+
+}  // namespace silkworm::lab
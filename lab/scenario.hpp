@@ -0,0 +1,124 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef SILKWORM_LAB_SCENARIO_HPP_
+#define SILKWORM_LAB_SCENARIO_HPP_
+
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "network.hpp"
+#include "sync.hpp"
+
+// Parameters of sync emulator runs, read from config files and the command
+// line so that experiments don't need recompiling, and their results as CSV.
+
+namespace silkworm::lab {
+
+enum class Backend { kMem, kLmdb };
+
+struct Scenario {
+  std::string name = "default";
+  uint32_t seed = 3548264823;
+  uint32_t start_block = 7212230;
+
+  // initial state
+  uint64_t initial_accounts = 10'000'000;
+  uint64_t initial_contracts = 10'000;
+
+  // per block
+  double block_time = 15;  // sec
+  unsigned new_accounts = 300;
+  unsigned updated_accounts = 0;  // picked from the initial ones
+  unsigned deleted_accounts = 0;  // picked from the initial ones
+  double reorg_probability = 0.05;
+  unsigned max_reorg_depth = 3;  // blocks
+  // gives up on syncs that can't keep up; zero for no limit
+  uint64_t max_blocks = 0;
+
+  // leechers
+  unsigned num_leechers = 1;
+  Backend backend = Backend::kMem;  // of the leechers' buckets
+  unsigned max_requests_in_flight = 4;
+  bool verify_replies = true;
+  // zero verifies inline, best for a single core
+  unsigned verifier_threads = std::thread::hardware_concurrency() / 2;
+  bool retune = true;  // once phase 1 is done
+
+  // num_leaves and changes_per_block follow the initial state & the
+  // workload unless set
+  sync::Hints hints;
+  std::optional<uint64_t> hinted_num_leaves;
+  std::optional<unsigned> hinted_changes_per_block;
+  // the miner serves the leechers' tree depth even if it can't keep it
+  // in memory; hints.max_memory if empty
+  std::optional<uint64_t> seeder_max_memory;
+
+  LinkModel link;
+
+  // Chrome trace of the first leecher's sync steps, for about:tracing or
+  // Perfetto; none if empty
+  std::string trace_file;
+
+  sync::Hints initial_hints() const;
+};
+
+// Sets a parameter by its name, e.g. "initial_accounts", from its text.
+// Numbers may have ' or _ digit separators.
+// Throws std::invalid_argument on unknown names or malformed values.
+void set_param(Scenario&, std::string_view name, std::string_view value);
+
+// one line per parameter: its name, value and description
+void print_params(std::ostream&, const Scenario&);
+
+// Reads "name = value" lines with # comments, divided into scenarios by
+// [name] headers. Each scenario starts from base with the parameters set
+// before the first header applied; a config without headers is a single
+// scenario.
+std::vector<Scenario> read_scenarios(std::istream&, const Scenario& base);
+
+// of a scenario for one of its leechers
+struct Result {
+  unsigned leecher = 0;
+  bool synced = false;  // within max_blocks
+  bool verified = false;
+  double emulated_time = 0;  // sec, until the sync was done or given up
+  double cpu_time = 0;       // sec, of the whole scenario
+  uint64_t new_blocks = 0;
+  uint64_t num_reorgs = 0;
+  uint64_t orphaned_blocks = 0;
+  uint64_t generated_leaves = 0;
+  uint64_t generated_storage_leaves = 0;
+  uint64_t packets_sent = 0;
+  uint64_t packets_lost = 0;
+  sync::Stats stats;
+
+  // reply bytes over the bytes of the leaves, minus one
+  double reply_overhead() const;
+};
+
+// The columns are the scenario parameters followed by the results.
+void write_csv_header(std::ostream&);
+void write_csv_row(std::ostream&, const Scenario&, const Result&);
+
+}  // namespace silkworm::lab
+
+#endif  // SILKWORM_LAB_SCENARIO_HPP_
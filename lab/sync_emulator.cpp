@@ -14,21 +14,31 @@
    limitations under the License.
 */
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include "contract_generator.hpp"
 #include "dust_generator.hpp"
 #include "keccak.hpp"
+#include "lmdb_bucket.hpp"
 #include "memdb_bucket.hpp"
+#include "metered_db_bucket.hpp"
 #include "miner.hpp"
+#include "network.hpp"
+#include "prefixed_db_bucket.hpp"
+#include "profiler.hpp"
+#include "scenario.hpp"
+#include "storage_sync.hpp"
+#include "tuner.hpp"
 
 using namespace silkworm;
-
-static const auto kInitialAccounts = 10'000'000;
-static const auto kNewAccountsPerBlock = 300;
-static const auto kBlockTime = 15;             // sec
-static const auto kBandwidth = 1'000'000 / 8;  // bytes per sec
+using namespace silkworm::lab;
 
 void print_hints(const sync::Hints& hints) {
   static constexpr double kKibibyte = 1024;
@@ -51,111 +61,478 @@ void print_hints(const sync::Hints& hints) {
             << hints.rqs(d2) / kMebibyte << " MiB \n\n";
 }
 
-int main() {
-  using namespace silkworm::lab;
-  using namespace boost::posix_time;
+void print_db_metrics(const DbMetrics& metrics) {
+  const auto ms = [](std::chrono::nanoseconds x) { return x.count() * 1e-6; };
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "puts                " << metrics.num_puts << " + "
+            << metrics.num_batch_puts << " batches of "
+            << metrics.num_batch_entries << " entries\n";
+  std::cout << "gets                " << metrics.num_gets << " ("
+            << metrics.num_misses << " misses)\n";
+  std::cout << "scans               " << metrics.num_scans << " of "
+            << metrics.num_scanned_entries << " entries, at most "
+            << metrics.max_scan_length << std::endl;
+  std::cout << "range dels          " << metrics.num_dels << std::endl;
+  std::cout << "bytes written/read  " << metrics.bytes_written << " / "
+            << metrics.bytes_read << std::endl;
+  std::cout << "commits             " << metrics.num_commits << " in "
+            << ms(metrics.commit_latency.total()) << " ms, p99 "
+            << metrics.commit_latency.quantile(0.99).count() * 1e-3
+            << " us\n";
+  std::cout << "scan time           " << ms(metrics.scan_latency.total())
+            << " ms\n";
+  if (metrics.lmdb) {
+    std::cout << "LMDB pages          " << metrics.lmdb->leaf_pages
+              << " leaf, " << metrics.lmdb->branch_pages << " branch, "
+              << metrics.lmdb->overflow_pages << " overflow\n";
+    std::cout << "LMDB map used       " << metrics.lmdb->env_used_bytes
+              << " of " << metrics.lmdb->env_map_size << " bytes\n";
+  }
+  std::cout << std::defaultfloat;
+}
+
+bool same_data(const DbBucket& a, const DbBucket& b) {
+  const auto mem_a = dynamic_cast<const MemDbBucket*>(&a);
+  const auto mem_b = dynamic_cast<const MemDbBucket*>(&b);
+  if (mem_a && mem_b) {
+    return mem_a->has_same_data(*mem_b);
+  }
 
-  static const auto kStartBlock = 7212230u;
-  static const auto kSeed = 3548264823u;
+  uint64_t num_a = 0;
+  bool same = true;
+  a.get("", {}, [&](std::string_view key, std::string_view val) {
+    ++num_a;
+    same = same && b.get(key) == val;
+  });
+  uint64_t num_b = 0;
+  b.get("", {}, [&](std::string_view, std::string_view) { ++num_b; });
+  return same && num_a == num_b;
+}
 
-  sync::Hints hints;
-  hints.changes_per_block = kNewAccountsPerBlock;
-  print_hints(hints);
+uint64_t num_entries(const DbBucket& db) {
+  uint64_t res = 0;
+  db.get("", {}, [&res](std::string_view, std::string_view) { ++res; });
+  return res;
+}
+
+std::unique_ptr<DbBucket> new_bucket(Backend backend,
+                                     const std::string& name) {
+  if (backend == Backend::kMem) {
+    return std::make_unique<MemDbBucket>(name);
+  }
+  // the environment outlives the scenario, so clean up after the last one
+  auto db = std::make_unique<LmdbBucket>(name);
+  db->del("", {});
+  return db;
+}
+
+// Syncs from the miner over its own pair of links.
+struct Leecher {
+  Leecher(const Scenario& scenario, unsigned index, const Miner& miner,
+          EventLoop& loop, const sync::Hints& hints)
+      : state{new_bucket(scenario.backend,
+                         "leecher_state_" + std::to_string(index))},
+        storage{new_bucket(scenario.backend,
+                           "leecher_storage_" + std::to_string(index))},
+        metered_state{*state},
+        node{metered_state, hints, {}, storage.get()},
+        // seeds + 2..4 are taken by the state generation and the workload
+        network_rng{scenario.seed + 1 + 4 * index},
+        uplink{loop, scenario.link, network_rng},
+        downlink{loop, scenario.link, network_rng},
+        session{loop,   node,     miner,
+                uplink, downlink, scenario.max_requests_in_flight,
+                stats} {
+    if (scenario.verify_replies) {
+      node.verify_replies(scenario.verifier_threads);
+    }
+    if (index == 0 && !scenario.trace_file.empty()) {
+      profiler.enable_trace();
+    }
+    node.set_profiler(&profiler);
+  }
+
+  std::unique_ptr<DbBucket> state;
+  std::unique_ptr<DbBucket> storage;
+  MeteredDbBucket metered_state;
+  Node node;
+  sync::Profiler profiler;
+  sync::Stats stats;
+  RNG network_rng;
+  Link uplink;
+  Link downlink;
+  SyncSession session;
+
+  // virtual time when the sync was first done
+  std::optional<double> sync_time;
+
+  // whether the data matched the miner's then; the miner moves on while
+  // the other leechers are still syncing
+  bool verified = false;
+};
 
-  hints.num_leaves = kInitialAccounts;
+std::vector<Result> run(const Scenario& scenario) {
+  using namespace boost::posix_time;
+
+  if (scenario.num_leechers == 0) {
+    throw std::invalid_argument("no leechers");
+  }
+  if (scenario.backend == Backend::kLmdb &&
+      2 * scenario.num_leechers > LmdbEnvironment::kMaxDBs) {
+    throw std::invalid_argument("too many leechers for LMDB");
+  }
+
+  auto hints = scenario.initial_hints();
   print_hints(hints);
 
   const auto time0 = microsec_clock::local_time();
   MemDbBucket miner_state("miner_state");
-  RNG rng(kSeed);
+  RNG rng(scenario.seed);
   DustGenerator dust_gen(rng);
 
   // create random dust accounts
-  int account_num = 0;
+  generate_dust(miner_state, scenario.seed, scenario.initial_accounts,
+                std::max(1u, std::thread::hardware_concurrency()));
+  std::cout << scenario.initial_accounts * 1e-6 << "M accounts generated"
+            << std::endl;
+
+  // create random contracts with storage
+  MemDbBucket miner_storage("miner_storage");
+  RNG contract_rng(scenario.seed + 2);
+  DustGenerator contract_account_gen(contract_rng);
+  ContractGenerator contract_gen(contract_rng);
+  uint64_t generated_storage_leaves = 0;
+
+  for (uint64_t i = 0; i < scenario.initial_contracts; ++i) {
+    const Hash key = keccak(byte_view(contract_account_gen.random_address()));
+    PrefixedDbBucket storage(miner_storage, byte_view(key));
+
+    const auto storage_size = contract_gen.random_storage_size();
+    for (size_t j = 0; j < storage_size; ++j) {
+      const Hash location = keccak(byte_view(contract_gen.random_location()));
+      storage.put(byte_view(location), contract_gen.random_value());
+    }
 
-  miner_state.put(
-      [&dust_gen, &account_num]() -> std::optional<DbBucket::KeyVal> {
-        if (account_num >= kInitialAccounts) {
-          return {};
-        }
-        if (account_num % 1'000'000 == 0) {
-          std::cout << account_num / 1'000'000 << "M accounts generated"
-                    << std::endl;
-        }
-        ++account_num;
+    Account account = contract_account_gen.random_account();
+    const auto leaves = read_storage(miner_storage, key);
+    account.storage = storage_root(leaves);
+    miner_state.put(byte_view(key), to_rlp(account));
 
-        Hash key = keccak(byte_view(dust_gen.random_address()));
-        std::string val = to_rlp(dust_gen.random_account());
-        return std::pair{byte_view(key), val};
-      });
+    generated_storage_leaves += leaves.size();
+  }
 
-  Miner miner(miner_state, hints, kStartBlock);
+  const auto miner_hints = [&scenario](sync::Hints h) {
+    h.max_memory = scenario.seeder_max_memory.value_or(h.max_memory);
+    return h;
+  };
+  Miner miner(miner_state, miner_hints(hints), scenario.start_block,
+              &miner_storage);
   const auto time1 = microsec_clock::local_time();
-  std::cout << "Dust accounts generated in " << time1 - time0 << "\n\n";
+  std::cout << "Accounts generated in " << time1 - time0 << "\n\n";
 
-  MemDbBucket leecher_state("leecher_state");
-  Node leecher(leecher_state, hints, {});
-  sync::Stats stats;
-  auto new_blocks = 0;
-  auto generated_leaves = kInitialAccounts;
+  EventLoop loop;
+  std::vector<std::unique_ptr<Leecher>> leechers;
+  for (unsigned i = 0; i < scenario.num_leechers; ++i) {
+    leechers.push_back(
+        std::make_unique<Leecher>(scenario, i, miner, loop, hints));
+  }
+  auto& first = *leechers.front();
+  miner.hash_deeper(first.node.depth());
+  auto new_blocks = 0u;
+  auto generated_leaves =
+      scenario.initial_accounts + scenario.initial_contracts;
+
+  for (auto& leecher : leechers) {
+    leecher->session.pump();
+  }
+
+  sync::Tuner tuner(hints);
+  bool tuned = false;
+  size_t num_paused = 0;
+
+  // separate from rng so that reorgs don't change the initial state
+  RNG reorg_rng(scenario.seed + 3);
+  std::bernoulli_distribution reorg_dist(scenario.reorg_probability);
+  auto chain_length = 0u;  // blocks since the start block on the current fork
+  auto num_reorgs = 0u;
+  auto orphaned_blocks = 0u;
+
+  // separate from rng so that updates & deletions don't change the new
+  // accounts
+  RNG workload_rng(scenario.seed + 4);
+  DustGenerator workload_gen(workload_rng);
+  std::uniform_int_distribution<uint64_t> initial_account_dist(
+      0, std::max<uint64_t>(scenario.initial_accounts, 1) - 1);
+  const auto changes_per_block = scenario.new_accounts +
+                                 scenario.updated_accounts +
+                                 scenario.deleted_accounts;
+
+  const auto mine_block = [&] {
+    miner.new_block();
+    for (unsigned i = 0; i < scenario.new_accounts; ++i) {
+      miner.create_account(dust_gen.random_address(),
+                           dust_gen.random_account());
+    }
+    if (scenario.initial_accounts > 0) {
+      for (unsigned i = 0; i < scenario.updated_accounts; ++i) {
+        const auto index = initial_account_dist(workload_rng);
+        miner.create_account(dust_address(scenario.seed, index),
+                             workload_gen.random_account());
+      }
+      for (unsigned i = 0; i < scenario.deleted_accounts; ++i) {
+        const auto index = initial_account_dist(workload_rng);
+        miner.delete_account(dust_address(scenario.seed, index));
+      }
+    }
+    miner.seal_block();
+    ++chain_length;
+  };
+
+  // restructures the trees of all nodes at once, the miner's included
+  const auto retune = [&] {
+    tuner.observe(*first.state);
+    tuner.observe(first.stats);
+    tuner.observe_blocks(new_blocks, uint64_t{new_blocks} * changes_per_block);
+    hints = tuner.hints();
+    std::cout << "\nRetuned after phase 1:\n";
+    print_hints(hints);
+    miner.retune(miner_hints(hints));
+    for (auto& leecher : leechers) {
+      leecher->node.retune(hints);
+    }
+    miner.hash_deeper(first.node.depth());
+    for (auto& leecher : leechers) {
+      leecher->session.resume();
+    }
+  };
 
   while (true) {
-    std::cout << "new block " << new_blocks << " phase "
-              << (leecher.phase1_sync_done() + 1) << std::endl;
+    std::cout << "new block " << new_blocks << " phase";
+    for (const auto& leecher : leechers) {
+      std::cout << ' ' << (leecher->node.phase1_sync_done() + 1);
+    }
+    std::cout << std::endl;
 
-    leecher.sync(miner, stats, kBandwidth * kBlockTime);
+    loop.run_until((new_blocks + 1) * scenario.block_time);
 
-    std::cout << "leaves received " << stats.reply_total_leaves
+    std::cout << "leaves received " << first.stats.reply_total_leaves
               << " vs generated " << generated_leaves << std::endl;
 
-    if (leecher.sync_done()) {
+    bool all_done = true;
+    bool all_phase1_done = true;
+    for (auto& leecher : leechers) {
+      if (!leecher->sync_time && leecher->node.sync_done()) {
+        leecher->sync_time = leecher->session.last_reply_time();
+        leecher->verified = same_data(miner_state, *leecher->state) &&
+                            same_data(miner_storage, *leecher->storage);
+      }
+      all_done = all_done && leecher->sync_time;
+      all_phase1_done = all_phase1_done && leecher->node.phase1_sync_done();
+    }
+    if (all_done) {
+      break;
+    }
+    if (scenario.max_blocks && new_blocks == scenario.max_blocks) {
+      std::cout << "\nGiving up after " << new_blocks << " blocks\n";
       break;
     }
 
-    miner.new_block();
-    for (int i = 0; i < kNewAccountsPerBlock; ++i) {
-      miner.create_account(dust_gen.random_address(),
-                           dust_gen.random_account());
+    if (scenario.retune && all_phase1_done && !tuned) {
+      tuned = true;
+      for (auto& leecher : leechers) {
+        leecher->session.pause([&] {
+          if (++num_paused == leechers.size()) {
+            retune();
+          }
+        });
+      }
     }
-    miner.seal_block();
 
-    generated_leaves += kNewAccountsPerBlock;
+    if (chain_length > 0 && reorg_dist(reorg_rng)) {
+      // switch to a longer fork branching off a few blocks back
+      std::uniform_int_distribution<unsigned> depth_dist(
+          1, std::min(chain_length, scenario.max_reorg_depth));
+      const auto depth = depth_dist(reorg_rng);
+      miner.unwind(depth);
+      chain_length -= depth;
+      for (unsigned i = 0; i < depth; ++i) {
+        mine_block();
+      }
+      ++num_reorgs;
+      orphaned_blocks += depth;
+    }
+
+    mine_block();
+
+    generated_leaves = scenario.initial_accounts + scenario.initial_contracts +
+                       chain_length * scenario.new_accounts;
     ++new_blocks;
-  }
 
-  std::cout << "\nSync done? " << std::boolalpha << leecher.sync_done()
-            << "\n\n";
+    for (auto& leecher : leechers) {
+      leecher->session.pump();
+    }
+  }
 
   const auto time2 = microsec_clock::local_time();
-  const auto emulated_time = seconds((new_blocks + 1) * kBlockTime);
-
-  std::cout << "CPU time            " << time2 - time1 << std::endl;
-  std::cout << "Emulated time       " << emulated_time << std::endl;
+  std::cout << "\nSync done in " << time2 - time1 << " CPU time\n";
   std::cout << "#new blocks         " << new_blocks << std::endl;
-  std::cout << "#requests           " << stats.num_requests << std::endl;
-  std::cout << "request total bytes " << stats.request_total_bytes << std::endl;
-  std::cout << "#replies            " << stats.num_replies << std::endl;
-  std::cout << "reply total bytes   " << stats.reply_total_bytes << std::endl;
-  std::cout << "reply total leaves  " << stats.reply_total_leaves << std::endl;
-  std::cout << "reply total nodes   " << stats.reply_total_nodes << std::endl;
+  std::cout << "#reorgs             " << num_reorgs << " ("
+            << orphaned_blocks << " blocks orphaned)" << std::endl;
+
+  // the deleted accounts may have been recreated
+  generated_leaves = num_entries(miner_state);
   std::cout << "generated leaves    " << generated_leaves << std::endl;
+  std::cout << "generated storage   " << generated_storage_leaves << "\n\n";
+
+  std::vector<Result> results;
+  for (unsigned i = 0; i < leechers.size(); ++i) {
+    const auto& leecher = *leechers[i];
+    const auto& stats = leecher.stats;
+
+    Result result;
+    result.leecher = i;
+    result.synced = leecher.sync_time.has_value();
+    result.verified = result.synced && leecher.verified;
+    result.emulated_time = leecher.sync_time.value_or(loop.now());
+    result.cpu_time = (time2 - time1).total_microseconds() * 1e-6;
+    result.new_blocks = new_blocks;
+    result.num_reorgs = num_reorgs;
+    result.orphaned_blocks = orphaned_blocks;
+    result.generated_leaves = generated_leaves;
+    result.generated_storage_leaves = generated_storage_leaves;
+    result.packets_sent =
+        leecher.uplink.packets_sent() + leecher.downlink.packets_sent();
+    result.packets_lost =
+        leecher.uplink.packets_lost() + leecher.downlink.packets_lost();
+    result.stats = stats;
+
+    const auto emulated_time =
+        microseconds(static_cast<int64_t>(result.emulated_time * 1e6));
+
+    std::cout << "Leecher " << i << ":\n";
+    std::cout << "Emulated time       " << emulated_time << std::endl;
+    std::cout << "#requests           " << stats.num_requests << std::endl;
+    std::cout << "request total bytes " << stats.request_total_bytes
+              << std::endl;
+    std::cout << "#replies            " << stats.num_replies << std::endl;
+    std::cout << "#rejected replies   " << stats.num_rejected_replies
+              << std::endl;
+    std::cout << "reply total bytes   " << stats.reply_total_bytes << std::endl;
+    std::cout << "reply total leaves  " << stats.reply_total_leaves
+              << std::endl;
+    std::cout << "reply total nodes   " << stats.reply_total_nodes << std::endl;
+    std::cout << "storage leaves      " << stats.reply_total_storage_leaves
+              << std::endl;
+    std::cout << "packets sent        " << result.packets_sent << std::endl;
+    std::cout << "packets lost        " << result.packets_lost << std::endl;
+    std::cout << "reply overhead      " << std::setprecision(2)
+              << result.reply_overhead() * 100 << "%\n\n";
+
+    std::cout << "Profile:\n";
+    leecher.profiler.print(std::cout);
+    std::cout << std::endl;
+    std::cout << "State db:\n";
+    print_db_metrics(leecher.metered_state.metrics());
+    std::cout << std::endl;
+
+    if (result.verified) {
+      std::cout << "Sync verified 😅\n\n";
+    } else if (!result.synced) {
+      std::cout << "Sync unfinished\n\n";
+    } else {
+      std::cout << "Epic Fail 🤬\n\n";
+    }
+    results.push_back(result);
+  }
+
+  if (const auto cache = miner.reply_cache()) {
+    std::cout << "Seeder reply cache: " << cache->hits() << " hits, "
+              << cache->misses() << " misses\n\n";
+  }
+
+  if (!scenario.trace_file.empty()) {
+    std::ofstream trace(scenario.trace_file);
+    first.profiler.write_trace(trace);
+  }
 
-  const auto leaf_bytes =
-      static_cast<double>(generated_leaves * sync::kLeafSize);
-  const auto overhead = stats.reply_total_bytes / leaf_bytes - 1;
-  std::cout << "reply overhead      " << std::setprecision(2) << overhead * 100
-            << "%\n\n";
+  return results;
+}
 
-  const bool same = miner_state.has_same_data(leecher_state);
+void print_usage(const char* program) {
+  std::cout << "Usage: " << program
+            << " [--config=FILE] [--csv=FILE] [--PARAM=VALUE ...]\n\n"
+               "Runs the scenarios of the config file, or a single one,\n"
+               "with the parameters given on the command line taking\n"
+               "precedence. Parameters and their defaults:\n";
+  print_params(std::cout, Scenario{});
+}
 
-  if (same) {
-    std::cout << "Sync verified 😅\n";
-  } else {
-    std::cout << "Epic Fail 🤬\n";
+int main(int argc, char* argv[]) {
+  std::string config_file;
+  std::string csv_file;
+  std::vector<std::pair<std::string, std::string>> overrides;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const auto eq = arg.find('=');
+    if (arg.substr(0, 2) != "--" || eq == std::string_view::npos) {
+      print_usage(argv[0]);
+      return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    const auto name = arg.substr(2, eq - 2);
+    const auto value = arg.substr(eq + 1);
+    if (name == "config") {
+      config_file = value;
+    } else if (name == "csv") {
+      csv_file = value;
+    } else {
+      overrides.emplace_back(name, value);
+    }
+  }
+
+  bool all_verified = true;
+  try {
+    std::vector<Scenario> scenarios{Scenario{}};
+    if (!config_file.empty()) {
+      std::ifstream config(config_file);
+      if (!config) {
+        throw std::runtime_error("cannot read " + config_file);
+      }
+      scenarios = read_scenarios(config, Scenario{});
+    }
+    for (auto& scenario : scenarios) {
+      for (const auto& [name, value] : overrides) {
+        set_param(scenario, name, value);
+      }
+    }
+
+    std::ofstream csv;
+    if (!csv_file.empty()) {
+      csv.open(csv_file);
+      if (!csv) {
+        throw std::runtime_error("cannot write " + csv_file);
+      }
+      write_csv_header(csv);
+    }
+
+    for (const auto& scenario : scenarios) {
+      std::cout << "Scenario " << scenario.name << ":\n";
+      print_params(std::cout, scenario);
+      std::cout << std::endl;
+
+      for (const auto& result : run(scenario)) {
+        all_verified = all_verified && result.verified;
+        if (csv.is_open()) {
+          write_csv_row(csv, scenario, result);
+        }
+      }
+      csv.flush();
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
   }
 
-  // TODO multiple leechers
-  // a) spawn leechers in separate threads
-  // b) keep mining new blocks
-  // c) wait for leechers to finish sync
+  return all_verified ? EXIT_SUCCESS : EXIT_FAILURE;
 }
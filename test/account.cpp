@@ -0,0 +1,58 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "account.hpp"
+
+#include <catch2/catch.hpp>
+
+#include "rlp.hpp"
+
+using namespace silkworm;
+
+TEST_CASE("Account RLP", "[rlp]") {
+  Account account;
+  account.nonce = 0x1234;
+  account.balance = 13 * kEther;
+  account.balance *= kEther;
+  account.storage =
+      "27407374bb099f172303644baef2dcc703c0e500b653ca82273b7b045d85a470"_x32;
+
+  const auto rlp = to_rlp(account);
+
+  char buf[kMaxAccountRlpSize];
+  REQUIRE(std::string(buf, to_rlp(account, buf)) == rlp);
+  const auto decoded = account_from_rlp(rlp);
+  REQUIRE(decoded.nonce == account.nonce);
+  REQUIRE(decoded.balance == account.balance);
+  REQUIRE(decoded.storage == account.storage);
+  REQUIRE(decoded.code == kEmptyStringHash);
+
+  REQUIRE(account_from_rlp(to_rlp(Account{})).balance == 0);
+
+  REQUIRE_THROWS_AS(account_from_rlp(rlp::encode("dog")),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(account_from_rlp(rlp::encode(rlp::List{"", "", "", ""})),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(account_from_rlp(rlp.substr(0, rlp.size() - 1)),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(account_from_rlp(rlp + rlp), std::invalid_argument);
+
+  // nonce with a leading zero
+  auto non_canonical = rlp;
+  REQUIRE(non_canonical[2] == '\x82');
+  non_canonical[3] = '\0';
+  REQUIRE_THROWS_AS(account_from_rlp(non_canonical), std::invalid_argument);
+}
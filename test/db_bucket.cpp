@@ -16,6 +16,8 @@
 
 #include "lmdb_bucket.hpp"
 #include "memdb_bucket.hpp"
+#include "metered_db_bucket.hpp"
+#include "prefixed_db_bucket.hpp"
 
 #include <string>
 #include <vector>
@@ -124,3 +126,112 @@ TEMPLATE_TEST_CASE("ranges", "[db]", MemDbBucket, LmdbBucket) {
   REQUIRE(res[1] == "dv");
   REQUIRE(res[2] == "e66434424z");
 }
+
+TEMPLATE_TEST_CASE("prefixed", "[db]", MemDbBucket, LmdbBucket) {
+  using namespace std::string_literals;
+
+  TestType db("test3");
+
+  db.put("d", "before");
+  db.put("de", "inside");
+  db.put("dezzz", "inside too");
+  db.put("e", "after");
+  db.put("\xff\xff", "last");
+
+  PrefixedDbBucket prefixed(db, "de");
+
+  REQUIRE(prefixed.get("zzz") == "inside too"s);
+  REQUIRE(!prefixed.get("e"));
+
+  prefixed.put("m", "new");
+  REQUIRE(db.get("dem") == "new"s);
+
+  std::vector<std::string> res;
+  prefixed.get("", {}, [&res](std::string_view key, std::string_view) {
+    res.emplace_back(key);
+  });
+  REQUIRE(res == std::vector<std::string>{"", "m", "zzz"});
+
+  prefixed.del("a", "n");
+  REQUIRE(!db.get("dem"));
+
+  prefixed.del("", {});
+  REQUIRE(db.get("d") == "before"s);
+  REQUIRE(!db.get("de"));
+  REQUIRE(!db.get("dezzz"));
+  REQUIRE(db.get("e") == "after"s);
+
+  // no upper bound for the all-0xff prefix
+  PrefixedDbBucket last(db, "\xff");
+  res.clear();
+  last.get("", {}, [&res](std::string_view key, std::string_view) {
+    res.emplace_back(key);
+  });
+  REQUIRE(res == std::vector<std::string>{"\xff"});
+}
+
+TEMPLATE_TEST_CASE("metered", "[db]", MemDbBucket, LmdbBucket) {
+  TestType db("test4");
+  MeteredDbBucket metered(db);
+
+  metered.put("abba", "ffdEEo)");
+  metered.put("dem", "_RER78");
+
+  std::vector<std::pair<std::string, std::string>> batch = {
+      {"dehrrer", "d532742u"}, {"dezzz", "qqqq"}, {"dv", "-6437"}};
+  auto it = batch.begin();
+  metered.put([&it, &batch]() -> std::optional<DbBucket::KeyVal> {
+    if (it == batch.end()) {
+      return {};
+    }
+    const auto& x = *it++;
+    return DbBucket::KeyVal{x.first, x.second};
+  });
+
+  REQUIRE(metered.get("dem"));
+  REQUIRE(!metered.get("zz"));
+
+  size_t scanned = 0;
+  metered.get("d", "e", [&scanned](std::string_view, std::string_view) {
+    ++scanned;
+  });
+  REQUIRE(scanned == 4);
+  metered.del("dv", {});
+
+  const auto metrics = metered.metrics();
+  REQUIRE(metrics.num_puts == 2);
+  REQUIRE(metrics.num_batch_puts == 1);
+  REQUIRE(metrics.num_batch_entries == 3);
+  REQUIRE(metrics.num_gets == 2);
+  REQUIRE(metrics.num_misses == 1);
+  REQUIRE(metrics.num_scans == 1);
+  REQUIRE(metrics.num_scanned_entries == 4);
+  REQUIRE(metrics.scan_lengths[2] == 1);  // 3 to 6 entries
+  REQUIRE(metrics.max_scan_length == 4);
+  REQUIRE(metrics.num_dels == 1);
+  REQUIRE(metrics.num_commits == 4);
+  REQUIRE(metrics.commit_latency.count() == 4);
+  REQUIRE(metrics.bytes_written == 11 + 9 + 15 + 9 + 7);
+  REQUIRE(metrics.bytes_read == 9 + 15 + 9 + 9 + 7);
+  REQUIRE(metrics.lmdb.has_value() == std::is_same_v<TestType, LmdbBucket>);
+  if (metrics.lmdb) {
+    REQUIRE(metrics.lmdb->entries == 4);
+    REQUIRE(metrics.lmdb->page_size > 0);
+  }
+
+  metered.reset_metrics();
+  REQUIRE(metered.metrics().num_puts == 0);
+}
+
+TEMPLATE_TEST_CASE("pin", "[db]", MemDbBucket, LmdbBucket) {
+  TestType db("test5");
+  db.put("abba", "ffdEEo)");
+
+  const auto pin = db.pin();
+  REQUIRE(static_cast<bool>(pin) == std::is_same_v<TestType, LmdbBucket>);
+
+  // other reads while pinned
+  REQUIRE(db.get("abba") == "ffdEEo)");
+  MeteredDbBucket metered(db);
+  REQUIRE(static_cast<bool>(metered.pin()) == static_cast<bool>(pin));
+}
@@ -84,3 +84,88 @@ TEMPLATE_TEST_CASE("Database leaves by prefix", "[db_util]", MemDbBucket,
   iterate(db, "fffff"_prefix, key_accumulator);
   REQUIRE(keys.size() == 1);
 }
+
+TEMPLATE_TEST_CASE("Replace leaves by prefix", "[db_util]", MemDbBucket,
+                   LmdbBucket) {
+  const Hash key1 =
+      "15d2460186f7233c927e7002dcc703c0e500b653ca3227363333aa089d1745ec"_x32;
+  const Hash key2 =
+      "15d2460186f7233c927e7002dcc703c0e500b653ca32273b7bfad8045d85a470"_x32;
+  const Hash key3 =
+      "15d2470000000000000000000000000000000000000000000000000000000000"_x32;
+  const Hash key4 =
+      "15d24f0000000000000000000000000000000000000000000000000000000000"_x32;
+  const Hash key5 =
+      "fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff475"_x32;
+
+  TestType db("replace_test");
+  db.put(byte_view(key1), "val");
+  db.put(byte_view(key2), "foo");
+  db.put(byte_view(key3), "kittie");
+  db.put(byte_view(key5), "bar");
+
+  const std::vector<std::pair<Hash, std::string>> leaves{
+      {key1, "val"}, {key3, "puppy"}, {key4, "new"}};
+  replace(db, "15d24"_prefix, leaves);
+
+  std::vector<std::pair<std::string, std::string>> entries;
+  auto accumulator = [&entries](std::string_view key, std::string_view val) {
+    entries.emplace_back(key, val);
+  };
+
+  iterate(db, Prefix(0), accumulator);
+  REQUIRE(entries.size() == 4);
+  CHECK(entries[0].first == byte_view(key1));
+  CHECK(entries[0].second == "val");
+  CHECK(entries[1].first == byte_view(key3));
+  CHECK(entries[1].second == "puppy");
+  CHECK(entries[2].first == byte_view(key4));
+  CHECK(entries[2].second == "new");
+  CHECK(entries[3].first == byte_view(key5));
+
+  replace(db, "15d24"_prefix, std::vector<std::pair<Hash, std::string>>{});
+  entries.clear();
+  iterate(db, Prefix(0), accumulator);
+  REQUIRE(entries.size() == 1);
+  CHECK(entries[0].first == byte_view(key5));
+}
+
+TEST_CASE("Replace merges adjacent deletes", "[db_util]") {
+  struct CountingBucket : MemDbBucket {
+    void del(std::string_view lower,
+             std::optional<std::string_view> upper) override {
+      ++num_deletes;
+      MemDbBucket::del(lower, upper);
+    }
+    int num_deletes = 0;
+  } db;
+
+  std::vector<std::pair<Hash, std::string>> leaves;
+  for (uint8_t i = 0; i < 8; ++i) {
+    Hash key{};
+    key[0] = i;
+    db.put(byte_view(key), "old");
+    if (i == 2 || i == 6) {
+      leaves.emplace_back(key, "old");
+    } else if (i == 4) {
+      leaves.emplace_back(key, "new");
+    }
+  }
+
+  // runs 0-1, 3-5 and 7 are deleted, the update at 4 inside the second
+  replace(db, Prefix(0), leaves);
+  CHECK(db.num_deletes == 3);
+
+  std::vector<std::pair<std::string, std::string>> entries;
+  iterate(db, Prefix(0),
+          [&entries](std::string_view key, std::string_view val) {
+            entries.emplace_back(key, val);
+          });
+  REQUIRE(entries.size() == 3);
+  CHECK(entries[0].first == byte_view(leaves[0].first));
+  CHECK(entries[0].second == "old");
+  CHECK(entries[1].first == byte_view(leaves[1].first));
+  CHECK(entries[1].second == "new");
+  CHECK(entries[2].first == byte_view(leaves[2].first));
+  CHECK(entries[2].second == "old");
+}
@@ -0,0 +1,90 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "hierarchical_bitmap.hpp"
+
+#include <random>
+
+#include <catch2/catch.hpp>
+
+using namespace silkworm;
+
+TEST_CASE("Hierarchical bitmap", "[bitmap]") {
+  SECTION("empty & full") {
+    HierarchicalBitmap empty(100'000);
+    CHECK(empty.find_next(0) == empty.size());
+
+    HierarchicalBitmap full(100'000, true);
+    CHECK(full.find_next(0) == 0);
+    CHECK(full.find_next(99'999) == 99'999);
+    CHECK(full.find_next(100'000) == full.size());
+  }
+
+  SECTION("same as a plain bitmap") {
+    const uint64_t size = 64 * 64 * 64 + 77;  // four levels
+    HierarchicalBitmap bitmap(size);
+    std::vector<bool> expected(size);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint64_t> pos(0, size - 1);
+    std::uniform_int_distribution<uint64_t> len(0, 5000);
+
+    for (int i = 0; i < 2000; ++i) {
+      switch (i % 4) {
+        case 0: {
+          const auto begin = pos(rng);
+          const auto end = std::min(size, begin + len(rng));
+          bitmap.set(begin, end);
+          std::fill(expected.begin() + begin, expected.begin() + end, true);
+          break;
+        }
+        case 1: {
+          const auto x = pos(rng);
+          bitmap.set(x);
+          expected[x] = true;
+          break;
+        }
+        case 2: {
+          const auto begin = pos(rng);
+          const auto end = std::min(size, begin + len(rng) / 2);
+          bitmap.reset(begin, end);
+          std::fill(expected.begin() + begin, expected.begin() + end, false);
+          break;
+        }
+        default: {
+          // clear a few set bits
+          for (auto x = bitmap.find_next(pos(rng)), n = len(rng) / 8;
+               x < size && n > 0; x = bitmap.find_next(x + 1), --n) {
+            REQUIRE(expected[x]);
+            bitmap.reset(x);
+            expected[x] = false;
+          }
+        }
+      }
+
+      const auto from = pos(rng);
+      auto next = from;
+      while (next < size && !expected[next]) {
+        ++next;
+      }
+      REQUIRE(bitmap.find_next(from) == next);
+    }
+
+    for (uint64_t i = 0; i < size; ++i) {
+      REQUIRE(bitmap.test(i) == expected[i]);
+    }
+  }
+}
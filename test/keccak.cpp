@@ -17,6 +17,7 @@
 #include "keccak.hpp"
 
 #include <string>
+#include <vector>
 
 #include <catch2/catch.hpp>
 
@@ -30,4 +31,25 @@ TEST_CASE("Keccak") {
         keccak(hex_string_to_bytes("68656c6c6f20776f726c64")) ==
         "47173285a8d7341e5e972fc677286384f802f8ef42a5ec5f03bbfa254cb01fad"_x32);
   }
+
+  SECTION("batch") {
+    // lengths around the rate of 136 bytes, so that inputs finish
+    // after different numbers of blocks
+    std::vector<std::string> inputs;
+    for (size_t len : {0, 1, 7, 8, 135, 136, 137, 272, 300, 31, 32}) {
+      std::string in(len, '\0');
+      for (size_t i = 0; i < len; ++i) {
+        in[i] = static_cast<char>(i * 7 + len);
+      }
+      inputs.push_back(in);
+    }
+
+    const std::vector<std::string_view> views(inputs.begin(), inputs.end());
+    std::vector<Hash> hashes(views.size());
+    keccak(views.data(), hashes.data(), views.size());
+
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      CHECK(hashes[i] == keccak(inputs[i]));
+    }
+  }
 }
@@ -0,0 +1,76 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "leaf_batch.hpp"
+
+#include <catch2/catch.hpp>
+
+using namespace silkworm;
+
+TEST_CASE("Leaf batch", "[sync]") {
+  const std::vector<sync::Leaf> leaves{
+      {"15d2460186f7233c927e7002dcc703c0e500b653ca3227363333aa089d1745ec"_x32,
+       "crypto kitties"},
+      {"15d2470000000000000000000000000000000000000000000000000000000000"_x32,
+       ""},
+      {"fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff475"_x32,
+       "teh DAO"},
+  };
+
+  sync::LeafBatch batch(leaves);
+  REQUIRE(batch.size() == 3);
+  CHECK(batch.value_bytes() == 21);
+  CHECK(batch[0].first == leaves[0].first);
+  CHECK(batch[0].second == "crypto kitties");
+  CHECK(batch[1].second.empty());
+  CHECK(batch.back().second == "teh DAO");
+  CHECK(batch.to_vector() == leaves);
+
+  size_t i = 0;
+  for (const auto& leaf : batch) {
+    CHECK(leaf.first == leaves[i++].first);
+  }
+  CHECK(i == 3);
+
+  sync::LeafBatch copy;
+  for (const auto& leaf : batch) {
+    copy.push_back(leaf.first, leaf.second);
+  }
+  CHECK(copy == batch);
+
+  batch.clear();
+  CHECK(batch.empty());
+  CHECK(batch.value_bytes() == 0);
+  CHECK(!(copy == batch));
+}
+
+TEST_CASE("Pinned leaf batch", "[sync]") {
+  const auto data =
+      std::make_shared<const std::string>("crypto kittiesteh DAO");
+  const std::string_view view(*data);
+
+  sync::LeafBatch batch(data);
+  batch.push_back(Hash{}, view.substr(0, 14));
+  batch.push_back(Hash{1}, view.substr(14));
+  REQUIRE(batch.size() == 2);
+  CHECK(batch[0].second.data() == data->data());
+  CHECK(batch.back().second == "teh DAO");
+  CHECK(batch.value_bytes() == 21);
+
+  const auto copy = sync::LeafBatch(batch.to_vector());
+  CHECK(copy == batch);
+  CHECK(copy[0].second.data() != data->data());
+}
@@ -19,6 +19,8 @@
 #include <catch2/catch.hpp>
 
 #include "memdb_bucket.hpp"
+#include "mptrie.hpp"
+#include "storage_sync.hpp"
 
 using namespace silkworm;
 
@@ -62,3 +64,202 @@ TEST_CASE("Block creation", "[miner]") {
   REQUIRE(leaf.first == key);
   REQUIRE(leaf.second == to_rlp(account));
 }
+
+TEST_CASE("Reorg", "[miner]") {
+  const auto block = 46732u;
+
+  sync::Hints hints;
+  hints.num_leaves = 1000;
+
+  const auto alice = "0000000000000000000000000000000000000001"_x20;
+  const auto bob = "0000000000000000000000000000000000000002"_x20;
+  const auto carol = "0000000000000000000000000000000000000003"_x20;
+
+  Account account;
+  account.balance = 17 * kEther;
+  const Hash location{};
+
+  const auto mine_common_block = [&](Miner& miner) {
+    miner.new_block();
+    miner.create_account(alice, account);
+    miner.set_storage(alice, location, "common");
+    miner.seal_block();
+  };
+
+  const auto root_node = [](const Miner& miner) {
+    sync::GetNodeRequest request;
+    request.prefixes.emplace_back(0);
+    const auto reply = miner.get_state_nodes(request);
+    REQUIRE(reply);
+    REQUIRE(reply->nodes[0]);
+    const auto& proof = *reply->nodes[0];
+    return std::pair{reply->block_number,
+                     mptrie::branch_node_hash(proof.empty, proof.hash)};
+  };
+
+  MemDbBucket state;
+  MemDbBucket storage;
+  Miner miner(state, hints, block, &storage);
+  mine_common_block(miner);
+
+  // a block on the old fork
+  account.balance = 5 * kEther;
+  miner.new_block();
+  miner.create_account(alice, account);
+  miner.create_account(bob, account);
+  miner.set_storage(alice, location, "old fork");
+  miner.set_storage(bob, location, "old fork");
+  miner.seal_block();
+
+  MemDbBucket other_state;
+  MemDbBucket other_storage;
+  Miner other(other_state, hints, block, &other_storage);
+  account.balance = 17 * kEther;
+  mine_common_block(other);
+
+  miner.unwind(1);
+
+  REQUIRE(state.has_same_data(other_state));
+  REQUIRE(storage.has_same_data(other_storage));
+
+  auto root = root_node(miner);
+  auto other_root = root_node(other);
+  CHECK(root.first == block + 1);
+  CHECK(root.second == other_root.second);
+
+  // the new fork
+  for (auto m : {&miner, &other}) {
+    m->new_block();
+    m->create_account(carol, account);
+    m->set_storage(alice, location, "");
+    m->seal_block();
+  }
+
+  REQUIRE(state.has_same_data(other_state));
+  REQUIRE(storage.has_same_data(other_storage));
+  CHECK(read_storage(storage, keccak(byte_view(alice))).empty());
+
+  root = root_node(miner);
+  other_root = root_node(other);
+  CHECK(root.first == block + 2);
+  CHECK(root.second == other_root.second);
+
+  // the journal starts at the block the miner was created at
+  CHECK_THROWS(miner.unwind(3));
+  CHECK_THROWS(miner.unwind(Miner::kMaxReorgDepth + 1));
+}
+
+TEST_CASE("Account deletion", "[miner]") {
+  const auto block = 46732u;
+
+  sync::Hints hints;
+  hints.num_leaves = 1000;
+
+  const auto alice = "0000000000000000000000000000000000000001"_x20;
+  const auto bob = "0000000000000000000000000000000000000002"_x20;
+  Account account;
+  account.balance = kEther;
+  const Hash location{};
+
+  MemDbBucket state;
+  MemDbBucket storage;
+  Miner miner(state, hints, block, &storage);
+  miner.new_block();
+  miner.create_account(alice, account);
+  miner.create_account(bob, account);
+  miner.set_storage(alice, location, "alice's");
+  miner.seal_block();
+
+  MemDbBucket state_before;
+  MemDbBucket storage_before;
+  Miner before(state_before, hints, block, &storage_before);
+  before.new_block();
+  before.create_account(bob, account);
+  before.seal_block();
+
+  miner.new_block();
+  miner.delete_account(alice);
+  miner.seal_block();
+
+  REQUIRE(!state.get(byte_view(keccak(byte_view(alice)))));
+  REQUIRE(state.has_same_data(state_before));
+  REQUIRE(storage.has_same_data(storage_before));
+
+  miner.unwind(1);
+  REQUIRE(state.get(byte_view(keccak(byte_view(alice)))));
+  REQUIRE(read_storage(storage, keccak(byte_view(alice))).size() == 1);
+}
+
+TEST_CASE("Historical state", "[miner]") {
+  const auto block = 46732u;
+
+  sync::Hints hints;
+  hints.num_leaves = 1000;
+
+  MemDbBucket state;
+  Miner miner(state, hints, block);
+
+  MemDbBucket past_state;
+  Miner past(past_state, hints, block);
+
+  const auto mine = [](Miner& m, uint8_t i) {
+    Address address{};
+    Account account;
+    m.new_block();
+    for (uint8_t j = 0; j < 100; ++j) {
+      address[0] = j;
+      account.balance = i * 1000 + j;
+      m.create_account(address, account);
+    }
+    m.seal_block();
+  };
+
+  mine(miner, 1);
+  mine(miner, 2);
+  mine(past, 1);
+  mine(past, 2);
+
+  for (uint8_t i = 3; i < 6; ++i) {
+    mine(miner, i);
+  }
+
+  const auto pinned = block + 2;
+  for (uint64_t p = 0; p < 16; ++p) {
+    auto request = sync::GetLeavesRequest{Prefix(1, p << 60)};
+    request.block_number = pinned;
+
+    const auto reply = miner.get_state_leaves(request);
+    const auto expected = past.get_state_leaves(request);
+    REQUIRE(reply.status == sync::LeavesReply::kOK);
+    CHECK(reply.block_number == pinned);
+    CHECK(reply.head_block == block + 5);
+    REQUIRE(reply.leaves);
+    CHECK(*reply.leaves == *expected.leaves);
+    REQUIRE(reply.proof.size() == 1);
+    CHECK(mptrie::branch_node_hash(reply.proof[0].empty,
+                                   reply.proof[0].hash) ==
+          mptrie::branch_node_hash(expected.proof[0].empty,
+                                   expected.proof[0].hash));
+  }
+
+  sync::GetNodeRequest request;
+  request.block_number = pinned;
+  for (uint64_t p = 0; p < 16; ++p) {
+    request.prefixes.emplace_back(1, p << 60);
+  }
+  const auto reply = miner.get_state_nodes(request);
+  const auto expected = past.get_state_nodes(request);
+  REQUIRE(reply);
+  CHECK(reply->block_number == pinned);
+  for (size_t i = 0; i < 16; ++i) {
+    REQUIRE(reply->nodes[i]);
+    CHECK(mptrie::branch_node_hash(reply->nodes[i]->empty,
+                                   reply->nodes[i]->hash) ==
+          mptrie::branch_node_hash(expected->nodes[i]->empty,
+                                   expected->nodes[i]->hash));
+  }
+
+  // the root is always served at the newest block
+  request.prefixes = {Prefix(0)};
+  CHECK(miner.get_state_nodes(request)->block_number == block + 5);
+}
@@ -0,0 +1,40 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "node.hpp"
+
+#include <catch2/catch.hpp>
+
+#include "memdb_bucket.hpp"
+
+using namespace silkworm;
+
+TEST_CASE("Retune", "[sync]") {
+  sync::Hints hints;
+  hints.num_leaves = 10'000;
+  hints.approx_max_reply_size = 512;
+
+  MemDbBucket db;
+  Node node(db, hints, {});
+  REQUIRE(node.depth() == 3);
+  REQUIRE(node.phase1_depth() == 3);
+
+  // larger replies call for a shallower phase 1 in the same tree
+  hints.approx_max_reply_size = 256 * 1024;
+  node.retune(hints);
+  REQUIRE(node.depth() == 3);
+  REQUIRE(node.phase1_depth() == 1);
+}
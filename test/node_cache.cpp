@@ -0,0 +1,53 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "node_cache.hpp"
+
+#include <catch2/catch.hpp>
+
+using namespace silkworm;
+
+TEST_CASE("Node cache", "[sync]") {
+  NodeCache cache(2);
+
+  sync::Proof node{};
+  node.empty[3] = false;
+
+  REQUIRE(!cache.find("274"_prefix));
+  cache.insert("274"_prefix, node);
+  cache.insert("2741"_prefix, node);
+  REQUIRE(cache.find("274"_prefix));
+  CHECK(cache.find("274"_prefix)->empty == node.empty);
+  CHECK(!cache.find("2740"_prefix));
+  CHECK(cache.hits() == 2);
+  CHECK(cache.misses() == 2);
+
+  // evicts 2741, the least recently used
+  cache.insert("f00"_prefix, node);
+  CHECK(cache.size() == 2);
+  CHECK(!cache.find("2741"_prefix));
+
+  cache.invalidate(
+      "2750000000000000000000000000000000000000000000000000000000000000"_x32);
+  CHECK(cache.find("274"_prefix));
+  cache.invalidate(
+      "274cc374bb09f9172122dcc70c03036123e0e178b654cd82273b7b045d85a499"_x32);
+  CHECK(!cache.find("274"_prefix));
+  CHECK(cache.find("f00"_prefix));
+
+  cache.clear();
+  CHECK(cache.size() == 0);
+}
@@ -0,0 +1,90 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "profiler.hpp"
+
+#include <sstream>
+
+#include <catch2/catch.hpp>
+
+#include "memdb_bucket.hpp"
+#include "state.hpp"
+
+using namespace silkworm;
+using namespace std::chrono_literals;
+
+TEST_CASE("Latency histogram", "[sync]") {
+  sync::Profiler::Histogram histogram;
+  for (int i = 0; i < 99; ++i) {
+    histogram.add(1000ns);
+  }
+  histogram.add(1ms);
+
+  REQUIRE(histogram.count() == 100);
+  REQUIRE(histogram.total() == 99us + 1ms);
+  REQUIRE(histogram.max() == 1ms);
+  REQUIRE(histogram.quantile(0.5) >= 1000ns);
+  REQUIRE(histogram.quantile(0.5) < 2000ns);
+  REQUIRE(histogram.quantile(0.99) < 2000ns);
+  REQUIRE(histogram.quantile(1) == 1ms);
+}
+
+TEST_CASE("Zero durations", "[sync]") {
+  sync::Profiler::Histogram histogram;
+  histogram.add(0ns);
+  histogram.add(0ns);
+
+  REQUIRE(histogram.count() == 2);
+  REQUIRE(histogram.total() == 0ns);
+  REQUIRE(histogram.quantile(1) == 0ns);
+}
+
+TEST_CASE("Profiled sync steps", "[sync]") {
+  const auto depth = 3u;
+  const auto phase1_depth = 2u;
+
+  MemDbBucket seeder_db;
+  Hash key{};
+  seeder_db.put(byte_view(key), "crypto kitties");
+  State seeder(seeder_db, depth, phase1_depth);
+  seeder.init_from_db(74);
+
+  sync::Profiler profiler;
+  profiler.enable_trace();
+
+  MemDbBucket leecher_db;
+  State leecher(leecher_db, depth, phase1_depth);
+  leecher.set_profiler(&profiler);
+
+  const auto request =
+      std::get<sync::GetLeavesRequest>(leecher.next_sync_request());
+  leecher.process_leaves_reply(request.prefix, seeder.get_leaves(request));
+
+  using Profiler = sync::Profiler;
+  for (const auto span : {Profiler::kNextRequest, Profiler::kLeavesReply,
+                          Profiler::kDbWrite, Profiler::kHashing}) {
+    REQUIRE(profiler.latency(span, 1).count() == 1);
+    REQUIRE(profiler.latency(span, 2).count() == 0);
+  }
+  REQUIRE(profiler.latency(Profiler::kNodeReply, 1).count() == 0);
+  REQUIRE(profiler.latency(Profiler::kHashing, 1).total() <=
+          profiler.latency(Profiler::kLeavesReply, 1).total());
+
+  std::ostringstream trace;
+  profiler.write_trace(trace);
+  REQUIRE(trace.str().find("\"name\":\"hashing\",\"cat\":\"phase1\"") !=
+          std::string::npos);
+}
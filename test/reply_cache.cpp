@@ -0,0 +1,106 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "reply_cache.hpp"
+
+#include <catch2/catch.hpp>
+
+#include "memdb_bucket.hpp"
+#include "state.hpp"
+
+using namespace silkworm;
+
+namespace {
+
+sync::LeavesReply reply_with(size_t num_leaves) {
+  sync::LeavesReply reply;
+  reply.leaves.emplace();
+  for (size_t i = 0; i < num_leaves; ++i) {
+    reply.leaves->push_back(Hash{static_cast<uint8_t>(i)}, "x");
+  }
+  return reply;
+}
+
+}  // namespace
+
+TEST_CASE("Reply cache", "[sync]") {
+  const auto reply = reply_with(10);
+  ReplyCache cache(3 * reply.byte_size());
+
+  const ReplyCache::Key a{"27"_prefix, 0, {}};
+  const ReplyCache::Key b{"274"_prefix, 2, {}};
+  const ReplyCache::Key c{"2741"_prefix, 3, {}};
+  const ReplyCache::Key d{"91"_prefix, 1, {}};
+
+  REQUIRE(!cache.find(a));
+  cache.insert(a, reply);
+  cache.insert(b, reply);
+  cache.insert(c, reply);
+  REQUIRE(cache.find(a));
+  REQUIRE(cache.find(a)->leaves->size() == 10);
+  CHECK(cache.hits() == 2);
+  CHECK(cache.misses() == 1);
+
+  // evicts b, the least recently used
+  cache.insert(d, reply);
+  CHECK(!cache.find(b));
+  CHECK(cache.find(c));
+  CHECK(cache.find(d));
+  CHECK(cache.bytes() == 3 * reply.byte_size());
+
+  // the proof of c starts at node 274, so a key under 275 leaves it be
+  cache.invalidate(
+      "2750000000000000000000000000000000000000000000000000000000000000"_x32);
+  CHECK(!cache.find(a));
+  CHECK(cache.find(c));
+  CHECK(cache.find(d));
+
+  cache.invalidate(
+      "2742ff0000000000000000000000000000000000000000000000000000000000"_x32);
+  CHECK(!cache.find(c));
+  CHECK(cache.find(d));
+
+  cache.clear();
+  CHECK(!cache.find(d));
+  CHECK(cache.bytes() == 0);
+}
+
+TEST_CASE("Cached leaves replies", "[sync]") {
+  const auto depth = 3u;
+
+  MemDbBucket db;
+  Hash key{};
+  key[0] = 0x27;
+  key[1] = 0x40;
+  db.put(byte_view(key), "crypto kitties");
+  State seeder(db, depth, depth);
+  seeder.keep_undo_journal(4);
+  seeder.init_from_db(74);
+  seeder.cache_replies(1 << 20);
+
+  sync::GetLeavesRequest request{"27"_prefix};
+  const auto first = seeder.get_leaves(request);
+  REQUIRE(seeder.get_leaves(request).leaves == first.leaves);
+  CHECK(seeder.reply_cache()->hits() == 1);
+
+  seeder.put(key, "teh DAO");
+  seeder.init_from_db(75);
+  const auto second = seeder.get_leaves(request);
+  REQUIRE(second.block_number == 75);
+  REQUIRE(second.leaves->size() == 1);
+  CHECK(second.leaves->front().second == "teh DAO");
+  CHECK(seeder.reply_cache()->hits() == 1);
+}
@@ -74,6 +74,21 @@ TEST_CASE("Recursive Length Prefix", "[rlp]") {
     }
   }
 
+  SECTION("encode into a buffer") {
+    for (const auto& x : kExamples) {
+      REQUIRE(encoded_length(x.first) == x.second.size());
+      std::string out(x.second.size() + 1, '!');
+      REQUIRE(encode_into(x.first, &out[0]) == &out[x.second.size()]);
+      REQUIRE(out == x.second + '!');
+    }
+
+    const List long_list(30, "dog");
+    const auto encoded = encode(long_list);
+    REQUIRE(encoded.substr(0, 2) == "\xf8\x78");
+    REQUIRE(encoded.size() == encoded_length(long_list));
+    REQUIRE(are_equal(decode(encoded), long_list));
+  }
+
   SECTION("decode examples") {
     for (const auto& x : kExamples) {
       INFO("decoding " + x.second);
@@ -81,17 +96,70 @@ TEST_CASE("Recursive Length Prefix", "[rlp]") {
     }
   }
 
-  // TODO: bad inputs, positive integers with leading zeroes
+  SECTION("bad inputs") {
+    const std::vector<std::string> kBad = {
+        "",
+        "\x83"
+        "do",
+        "\xc8\x83"
+        "cat",
+        "\xb8",
+        // non-canonical
+        "\x81\x05",
+        "\xb8\x05"
+        "hello",
+        "\xb9\x00\x38" + std::string(56, 'x'),
+        "\xf8\x01\x80",
+        // extra input
+        "\x80\x80",
+    };
+    for (const auto& x : kBad) {
+      INFO("decoding " + x);
+      REQUIRE_THROWS_AS(decode(x), std::invalid_argument);
+    }
+  }
+
   /* From the Yellow Paper:
   When interpreting RLP data, if an expected fragment is decoded as a scalar and
   leading zeroes are found in the byte sequence, clients are required to
   consider it non-canonical and treat it in the same manner as otherwise invalid
   RLP data, dismissing it completely.
   */
+  SECTION("reader") {
+    const auto in = encode(List{"cat", List{"\x04\x00"s, ""}, "\x00\x01"s});
+    Reader reader(in);
+    auto list = reader.read_list();
+    REQUIRE(reader.empty());
+
+    const auto cat = list.read_string();
+    REQUIRE(cat == "cat");
+    REQUIRE(cat.data() >= in.data());
+    REQUIRE(cat.data() < in.data() + in.size());
+
+    REQUIRE(list.next_is_list());
+    auto inner = list.read_list();
+    REQUIRE(inner.read_uint64() == 1024);
+    REQUIRE(inner.read_uint256() == 0);
+    REQUIRE(inner.empty());
 
-  SECTION("big_endian: uint64_t vs boost multiprecision") {
+    REQUIRE_THROWS_AS(Reader(list).read_uint64(), std::invalid_argument);
+    REQUIRE_THROWS_AS(Reader(list).read_list(), std::invalid_argument);
+    list.skip();
+    REQUIRE(list.empty());
+    REQUIRE_THROWS_AS(list.read_string(), std::invalid_argument);
+  }
+
+  SECTION("big_endian: uint64_t vs UInt256") {
     const uint64_t scalar1 = 0xf409785633ef3294;
     const UInt256 scalar2 = scalar1;
     REQUIRE(to_big_endian(scalar1) == to_big_endian(scalar2));
+    REQUIRE(to_big_endian(UInt256{0}).empty());
+
+    char buf[32];
+    REQUIRE(to_big_endian(uint64_t{0}, buf) == buf);
+    REQUIRE(to_big_endian(uint64_t{0x0400}, buf) == buf + 2);
+    REQUIRE(std::string(buf, 2) == "\x04\x00"s);
+    REQUIRE(big_endian_length(scalar1) == 8);
+    REQUIRE(to_big_endian(scalar2 << 128, buf) == buf + 24);
   }
 }
@@ -0,0 +1,158 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "rlp_schema.hpp"
+
+#include <catch2/catch.hpp>
+
+#include "memdb_bucket.hpp"
+#include "state.hpp"
+#include "sync_rlp.hpp"
+
+using namespace silkworm;
+
+namespace {
+
+struct Transfer {
+  uint64_t nonce = 0;
+  UInt256 value = 0;
+  std::optional<Hash> to;
+  std::vector<std::pair<uint8_t, std::string>> notes;
+};
+
+}  // namespace
+
+namespace silkworm::rlp {
+
+template <>
+struct Codec<Transfer> : Schema<Transfer, &Transfer::nonce, &Transfer::value,
+                                &Transfer::to, &Transfer::notes> {};
+
+}  // namespace silkworm::rlp
+
+TEST_CASE("RLP schema", "[rlp]") {
+  using namespace silkworm::rlp;
+  using namespace std::string_literals;
+
+  Transfer transfer;
+  transfer.nonce = 0x7f;
+  transfer.value = UInt256{1} << 200;
+  transfer.to = Hash{};
+  (*transfer.to)[5] = 0xde;
+  transfer.notes = {{0, ""}, {0x80, "crypto kitties"}};
+
+  SECTION("same as the generic encoding") {
+    List notes;
+    for (const auto& note : transfer.notes) {
+      notes.push_back(List{to_big_endian(note.first), note.second});
+    }
+    const Item item =
+        List{to_big_endian(transfer.nonce), to_big_endian(transfer.value),
+             List{std::string(byte_view(*transfer.to))}, notes};
+
+    const auto encoded = Codec<Transfer>::encode(transfer);
+    REQUIRE(encoded == rlp::encode(item));
+    REQUIRE(Codec<Transfer>::length(transfer) == encoded.size());
+
+    Transfer decoded;
+    Codec<Transfer>::decode(encoded, decoded);
+    REQUIRE(decoded.nonce == transfer.nonce);
+    REQUIRE(decoded.value == transfer.value);
+    REQUIRE(decoded.to == transfer.to);
+    REQUIRE(decoded.notes == transfer.notes);
+  }
+
+  SECTION("missing optional") {
+    transfer.to.reset();
+    transfer.notes.clear();
+    const auto encoded = Codec<Transfer>::encode(transfer);
+    REQUIRE(encoded.substr(encoded.size() - 2) == "\xc0\xc0");
+
+    Transfer decoded;
+    decoded.to = Hash{};
+    Codec<Transfer>::decode(encoded, decoded);
+    REQUIRE(!decoded.to);
+    REQUIRE(decoded.notes.empty());
+  }
+
+  SECTION("bad input") {
+    const auto encoded = Codec<Transfer>::encode(transfer);
+    Transfer decoded;
+    REQUIRE_THROWS_AS(Codec<Transfer>::decode(encoded + '\0', decoded),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(Codec<Transfer>::decode(encode(List{"\x7f"}), decoded),
+                      std::invalid_argument);
+    // note key doesn't fit into uint8_t
+    REQUIRE_THROWS_AS(Codec<Transfer>::decode(
+                          encode(List{"\x7f", "", List{},
+                                      List{List{"\x01\x00"s, ""}}}),
+                          decoded),
+                      std::invalid_argument);
+  }
+}
+
+TEST_CASE("Sync messages RLP", "[rlp]") {
+  using namespace silkworm::rlp;
+  const auto depth = 3u;
+
+  MemDbBucket db;
+  for (uint8_t i = 0; i < 10; ++i) {
+    Hash key{};
+    key[0] = 0x27;
+    key[1] = i * 30;
+    db.put(byte_view(key), std::string(i + 1, 'x'));
+  }
+  State seeder(db, depth, depth);
+  seeder.init_from_db(74);
+
+  sync::GetLeavesRequest request{"27"_prefix};
+  request.account = Hash{};
+  request.block_number = 74;
+  request.from_level = 1;
+  const auto encoded_request = Codec<sync::GetLeavesRequest>::encode(request);
+  sync::GetLeavesRequest decoded_request{Prefix{0}};
+  Codec<sync::GetLeavesRequest>::decode(encoded_request, decoded_request);
+  REQUIRE(decoded_request.account == request.account);
+  REQUIRE(decoded_request.prefix == request.prefix);
+  REQUIRE(decoded_request.block_number == request.block_number);
+  REQUIRE(decoded_request.from_level == request.from_level);
+
+  request.account.reset();
+  const auto reply = seeder.get_leaves(request);
+  REQUIRE(reply.proof.size() == 1);
+  REQUIRE(reply.leaves);
+  const auto encoded_reply = Codec<sync::LeavesReply>::encode(reply);
+  sync::LeavesReply decoded_reply;
+  Codec<sync::LeavesReply>::decode(encoded_reply, decoded_reply);
+  REQUIRE(decoded_reply.block_number == 74);
+  REQUIRE(decoded_reply.proof[0].empty == reply.proof[0].empty);
+  REQUIRE(mptrie::branch_node_hash(decoded_reply.proof[0].empty,
+                                   decoded_reply.proof[0].hash) ==
+          mptrie::branch_node_hash(reply.proof[0].empty, reply.proof[0].hash));
+  REQUIRE(decoded_reply.leaves == reply.leaves);
+
+  sync::GetNodeRequest node_request{{}, {""_prefix, "2"_prefix}, {}};
+  const auto node_reply = *seeder.get_nodes(node_request);
+  sync::NodeReply decoded_node_reply;
+  Codec<sync::NodeReply>::decode(Codec<sync::NodeReply>::encode(node_reply),
+                                 decoded_node_reply);
+  REQUIRE(decoded_node_reply.nodes.size() == 2);
+  REQUIRE(decoded_node_reply.nodes[0]);
+  REQUIRE(decoded_node_reply.nodes[1]);
+  REQUIRE(mptrie::branch_node_hash(decoded_node_reply.nodes[0]->empty,
+                                   decoded_node_reply.nodes[0]->hash) ==
+          seeder.root_hash());
+}
@@ -18,6 +18,7 @@
 
 #include <catch2/catch.hpp>
 
+#include "keccak.hpp"
 #include "memdb_bucket.hpp"
 
 using namespace silkworm;
@@ -126,6 +127,273 @@ TEST_CASE("Phase 1 sync", "[sync]") {
     REQUIRE(new_reply.leaves);
     REQUIRE(*new_reply.leaves == leaves);
   }
+}
+
+TEST_CASE("Phase 2 sync", "[sync]") {
+  const auto depth = 3u;
+  const auto phase1_depth = 2u;
+
+  int32_t block = 74;
+  const auto last_block = block + 60;
+
+  MemDbBucket seeder_db;
+  std::vector<Hash> keys;
+  for (int i = 0; i < 500; ++i) {
+    const auto val = std::to_string(i);
+    keys.push_back(keccak(val));
+    seeder_db.put(byte_view(keys.back()), val);
+  }
+  State seeder(seeder_db, depth, phase1_depth);
+  seeder.init_from_db(block);
+
+  // a block updating, adding and deleting a leaf each
+  const auto mine = [&](State& state) {
+    state.put(keys[block % keys.size()], "v" + std::to_string(block));
+    state.put(keccak("new" + std::to_string(block)), "new");
+    state.del(keys[block * 7 % keys.size()]);
+  };
+
+  MemDbBucket leecher_db;
+  State leecher(leecher_db, depth, phase1_depth);
+
+  bool mined_mid_sync = false;
+  for (int i = 0; i < 10000; ++i) {
+    if (i % 5 == 0 && block < last_block) {
+      mined_mid_sync |= leecher.phase1_sync_done() &&
+                        leecher.synced_block() == -1;
+      mine(seeder);
+      seeder.init_from_db(++block);
+    }
+
+    const auto request = leecher.next_sync_request();
+    if (const auto r = std::get_if<sync::GetLeavesRequest>(&request)) {
+      leecher.process_leaves_reply(r->prefix, seeder.get_leaves(*r));
+    } else if (const auto r = std::get_if<sync::GetNodeRequest>(&request)) {
+      if (const auto reply = seeder.get_nodes(*r)) {
+        leecher.process_node_reply(*r, *reply);
+      }
+    } else if (block == last_block && leecher.synced_block() == block) {
+      break;
+    } else {
+      leecher.resume_sync();
+    }
+  }
+  REQUIRE(mined_mid_sync);
+  REQUIRE(leecher.synced_block() == last_block);
+  REQUIRE(leecher.root_hash() == seeder.root_hash());
+  REQUIRE(leecher_db.has_same_data(seeder_db));
+
+  // the branch hashes cached by root_hash are redone for a new block
+  mine(seeder);
+  seeder.init_from_db(block + 1);
+  mine(leecher);
+  leecher.init_from_db(block + 1);
+  REQUIRE(leecher.root_hash() == seeder.root_hash());
+
+  State fresh(leecher_db, depth, phase1_depth);
+  fresh.init_from_db(block + 1);
+  REQUIRE(leecher.root_hash() == fresh.root_hash());
+  REQUIRE(leecher.root_hash() != State::root_hash(depth, {}));
+}
+
+TEST_CASE("Restructure", "[sync]") {
+  const auto block = 74;
+
+  MemDbBucket db;
+  db.put(
+      byte_view(
+          "27407374bb099f172303644baef2dcc703c0e500b653ca82273b7b045d85a470"_x32),
+      "crypto kitties");
+  db.put(
+      byte_view(
+          "274cc374bb09f9172122dcc70c03036123e0e178b654cd82273b7b045d85a499"_x32),
+      "teh DAO");
+
+  State deep(db, 4, 2);
+  deep.init_from_db(block);
+
+  State state(db, 3, 2);
+  state.init_from_db(block);
+  REQUIRE(state.synced_block() == block);
+
+  state.restructure(4, 2);
+  REQUIRE(state.depth() == 4);
+
+  // the data is no longer tied to a block
+  REQUIRE(state.synced_block() == -1);
+  sync::GetLeavesRequest request{"274"_prefix};
+  REQUIRE(state.get_leaves(request).status ==
+          sync::LeavesReply::kDontHaveData);
+
+  state.init_from_db(block);
+  REQUIRE(state.synced_block() == block);
+
+  const sync::GetNodeRequest node_request{{}, {""_prefix, "27"_prefix}, block};
+  const auto expected = deep.get_nodes(node_request);
+  const auto actual = state.get_nodes(node_request);
+  for (size_t i = 0; i < node_request.prefixes.size(); ++i) {
+    REQUIRE(actual->nodes[i]->empty == expected->nodes[i]->empty);
+    REQUIRE(actual->nodes[i]->hash == expected->nodes[i]->hash);
+  }
+
+  REQUIRE_THROWS(state.restructure(1, 1));
+}
+
+TEST_CASE("Phase 1 depth", "[sync]") {
+  const auto block = 74;
+
+  MemDbBucket seeder_db;
+  for (int i = 0; i < 300; ++i) {
+    const auto val = std::to_string(i);
+    seeder_db.put(byte_view(keccak(val)), val);
+  }
+  State seeder(seeder_db, 3, 1);
+  seeder.init_from_db(block);
+
+  MemDbBucket leecher_db;
+  State leecher(leecher_db, 3, 1);
+  REQUIRE(leecher.phase1_depth() == 1);
+
+  const auto step = [&]() {
+    const auto request = leecher.next_sync_request();
+    const auto r = std::get_if<sync::GetLeavesRequest>(&request);
+    REQUIRE(r);
+    leecher.process_leaves_reply(r->prefix, seeder.get_leaves(*r));
+    return r->prefix;
+  };
+
+  for (uint64_t i = 0; i < 3; ++i) {
+    REQUIRE(step() == Prefix(1, i << 60));
+  }
+
+  // deeper, phase 1 carries on where it got to
+  leecher.set_phase1_depth(3);
+  REQUIRE(leecher.phase1_depth() == 3);
+  REQUIRE(step() == "300"_prefix);
+  for (int i = 0; i < 100; ++i) {
+    REQUIRE(step().size() == 3);
+  }
+
+  // shallower, the partly done prefix is requested whole
+  leecher.set_phase1_depth(2);
+  const auto prefix = step();
+  REQUIRE(prefix.size() == 2);
+  REQUIRE(prefix[0] == 3);
+
+  for (int i = 0; i < 1000 && !leecher.phase1_sync_done(); ++i) {
+    const auto request = leecher.next_sync_request();
+    if (const auto r = std::get_if<sync::GetLeavesRequest>(&request);
+        r && !leecher.phase1_sync_done()) {
+      leecher.process_leaves_reply(r->prefix, seeder.get_leaves(*r));
+    }
+  }
+  REQUIRE(leecher.phase1_sync_done());
+  REQUIRE(leecher_db.has_same_data(seeder_db));
+
+  REQUIRE_THROWS(leecher.set_phase1_depth(4));
+}
+
+TEST_CASE("Root hash", "[sync]") {
+  std::vector<sync::Leaf> leaves = {
+      {"27407374bb099f172303644baef2dcc703c0e500b653ca82273b7b045d85a470"_x32,
+       "crypto kitties"},
+      {"274cc374bb09f9172122dcc70c03036123e0e178b654cd82273b7b045d85a499"_x32,
+       "teh DAO"},
+      {"f0000000000000000000000000000000000000000000000000000000000000ff"_x32,
+       "dust"},
+  };
+
+  MemDbBucket db;
+  for (const auto& leaf : leaves) {
+    db.put(byte_view(leaf.first), leaf.second);
+  }
+
+  for (uint8_t depth = 2; depth < 5; ++depth) {
+    State state(db, depth, 2);
+    state.init_from_db(0);
+    REQUIRE(state.root_hash() == State::root_hash(depth, leaves));
+  }
+
+  MemDbBucket empty_db;
+  State empty(empty_db, 3, 2);
+  empty.init_from_db(0);
+  REQUIRE(empty.root_hash() == State::root_hash(3, {}));
+}
+
+TEST_CASE("Nodes below the tree", "[sync]") {
+  const auto block = 74;
+
+  MemDbBucket db;
+  db.put(
+      byte_view(
+          "27407374bb099f172303644baef2dcc703c0e500b653ca82273b7b045d85a470"_x32),
+      "crypto kitties");
+  db.put(
+      byte_view(
+          "274cc374bb09f9172122dcc70c03036123e0e178b654cd82273b7b045d85a499"_x32),
+      "teh DAO");
+  db.put(
+      byte_view(
+          "f0000000000000000000000000000000000000000000000000000000000000ff"_x32),
+      "dust");
+
+  State deep(db, 4, 2);
+  deep.init_from_db(block);
+
+  State seeder(db, 2, 2);
+  seeder.init_from_db(block);
+  seeder.hash_deeper(4, 16);
+  REQUIRE(seeder.depth() == 2);
+  REQUIRE(seeder.hash_depth() == 4);
+  REQUIRE(seeder.root_hash() == deep.root_hash());
+
+  const sync::GetNodeRequest node_request{
+      {}, {"27"_prefix, "274"_prefix, "f00"_prefix, "2741"_prefix}, block};
+  const auto expected = deep.get_nodes(node_request);
+  const auto actual = seeder.get_nodes(node_request);
+  for (size_t i = 0; i < 3; ++i) {
+    REQUIRE(actual->nodes[i]);
+    REQUIRE(actual->nodes[i]->empty == expected->nodes[i]->empty);
+    REQUIRE(actual->nodes[i]->hash == expected->nodes[i]->hash);
+  }
+  REQUIRE(!actual->nodes[3]);  // as deep as the leaves
+
+  const sync::GetLeavesRequest leaves_request{"274c"_prefix};
+  const auto deep_leaves = deep.get_leaves(leaves_request);
+  const auto leaves = seeder.get_leaves(leaves_request);
+  REQUIRE(leaves.proof.size() == 4);
+  for (size_t i = 0; i < 4; ++i) {
+    REQUIRE(leaves.proof[i].empty == deep_leaves.proof[i].empty);
+    REQUIRE(leaves.proof[i].hash == deep_leaves.proof[i].hash);
+  }
+  REQUIRE(leaves.leaves == deep_leaves.leaves);
+
+  // a leecher with the deeper tree syncs off the seeder
+  MemDbBucket leecher_db;
+  State leecher(leecher_db, 4, 2);
+  for (int i = 0; i < 1000 && leecher.synced_block() != block; ++i) {
+    const auto request = leecher.next_sync_request();
+    if (const auto r = std::get_if<sync::GetLeavesRequest>(&request)) {
+      leecher.process_leaves_reply(r->prefix, seeder.get_leaves(*r));
+    } else if (const auto r = std::get_if<sync::GetNodeRequest>(&request)) {
+      leecher.process_node_reply(*r, *seeder.get_nodes(*r));
+    }
+  }
+  REQUIRE(leecher.synced_block() == block);
+  REQUIRE(leecher.root_hash() == deep.root_hash());
+  REQUIRE(leecher_db.has_same_data(db));
+
+  // the nodes computed before are stale after a write
+  const auto key =
+      "274cc374bb09f9172122dcc70c03036123e0e178b654cd82273b7b045d85a499"_x32;
+  seeder.put(key, "Parity multisig");
+  seeder.init_from_db(block + 1);
+  deep.put(key, "Parity multisig");
+  deep.init_from_db(block + 1);
+  REQUIRE(seeder.root_hash() == deep.root_hash());
+  REQUIRE(seeder.get_nodes(node_request)->nodes[1]->hash ==
+          deep.get_nodes(node_request)->nodes[1]->hash);
 
-  // TODO test phase 2 sync
+  REQUIRE_THROWS(leecher.hash_deeper(3, 16));
+  REQUIRE_THROWS(seeder.process_leaves_reply(leaves_request.prefix, leaves));
 }
@@ -0,0 +1,183 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "storage_sync.hpp"
+
+#include <catch2/catch.hpp>
+
+#include "memdb_bucket.hpp"
+#include "miner.hpp"
+
+using namespace silkworm;
+
+TEST_CASE("Storage sync", "[sync]") {
+  const auto block = 4370000u;
+
+  sync::Hints hints;
+  hints.num_leaves = 1000;
+
+  MemDbBucket seeder_state;
+  MemDbBucket seeder_storage;
+  Miner miner(seeder_state, hints, block, &seeder_storage);
+
+  Account account;
+  account.balance = 17 * kEther;
+
+  const auto dust = "0000000000000000000000000000000000000001"_x20;
+  const auto small_contract = "0000000000000000000000000000000000000002"_x20;
+  const auto large_contract = "0000000000000000000000000000000000000003"_x20;
+
+  miner.new_block();
+  miner.create_account(dust, account);
+  miner.create_account(small_contract, account);
+  miner.create_account(large_contract, account);
+
+  Hash location{};
+  for (uint8_t i = 0; i < 3; ++i) {
+    location[31] = i;
+    miner.set_storage(small_contract, location, "small");
+  }
+  const auto num_large_leaves = sync::kMaxLeavesPerStorageReply * 4;
+  for (size_t i = 0; i < num_large_leaves; ++i) {
+    location[30] = i / 256;
+    location[31] = i % 256;
+    miner.set_storage(large_contract, location, "large");
+  }
+  miner.seal_block();
+
+  const auto small_key = keccak(byte_view(small_contract));
+  const auto storage_root_of = [&seeder_state](const Hash& key) {
+    return account_from_rlp(*seeder_state.get(byte_view(key))).storage;
+  };
+  REQUIRE(storage_root_of(keccak(byte_view(dust))) == kEmptyStringHash);
+  REQUIRE(storage_root_of(small_key) ==
+          storage_root(read_storage(seeder_storage, small_key)));
+
+  SECTION("batched request") {
+    sync::GetStorageRequest request;
+    request.accounts = {small_key, keccak(byte_view(large_contract)),
+                        keccak(byte_view(dust))};
+    const auto reply = miner.get_storage(request);
+    REQUIRE(reply.block_number == block + 1);
+    REQUIRE(reply.storage.size() == 3);
+    REQUIRE(reply.storage[0].status == sync::LeavesReply::kOK);
+    REQUIRE(reply.storage[0].leaves.size() == 3);
+    REQUIRE(reply.storage[1].status == sync::LeavesReply::kTooManyLeaves);
+    REQUIRE(reply.storage[1].num_leaves == num_large_leaves);
+    REQUIRE(reply.storage[2].status == sync::LeavesReply::kOK);
+    REQUIRE(reply.storage[2].leaves.empty());
+  }
+
+  SECTION("full sync") {
+    MemDbBucket leecher_state;
+    MemDbBucket leecher_storage;
+    Node leecher(leecher_state, hints, {}, &leecher_storage);
+
+    // stale storage must go
+    const auto stale_key =
+        std::string(byte_view(small_key)) + std::string(32, 'x');
+    leecher_storage.put(stale_key, "stale");
+
+    sync::Stats stats;
+    for (int i = 0; i < 100 && !leecher.sync_done(); ++i) {
+      leecher.sync(miner, stats, 1'000'000);
+    }
+
+    REQUIRE(leecher.sync_done());
+    REQUIRE(leecher_state.has_same_data(seeder_state));
+    REQUIRE(leecher_storage.has_same_data(seeder_storage));
+    REQUIRE(stats.reply_total_storage_leaves >= 3 + num_large_leaves);
+  }
+
+  SECTION("only changed accounts rechecked") {
+    // counts the reads of the leecher's storage
+    struct CountingBucket : MemDbBucket {
+      using MemDbBucket::get;
+      void get(std::string_view lower, std::optional<std::string_view> upper,
+               const std::function<void(std::string_view, std::string_view)>&
+                   f) const override {
+        ++num_reads;
+        MemDbBucket::get(lower, upper, f);
+      }
+      mutable int num_reads = 0;
+    };
+
+    MemDbBucket leecher_state;
+    CountingBucket leecher_storage;
+    Node leecher(leecher_state, hints, {}, &leecher_storage);
+    sync::Stats stats;
+    for (int i = 0; i < 100 && !leecher.sync_done(); ++i) {
+      leecher.sync(miner, stats, 1'000'000);
+    }
+    REQUIRE(leecher.sync_done());
+
+    leecher_storage.num_reads = 0;
+    StorageSync storage_sync(leecher_state, leecher_storage, block + 1);
+    REQUIRE(storage_sync.done());
+    REQUIRE(leecher_storage.num_reads == 2);  // the first pass reads all
+
+    // the storage root is the one verified before
+    storage_sync.move_to_block(block + 2, {small_key});
+    REQUIRE(storage_sync.done());
+
+    // the storage in the db is known not to match a new root
+    auto small_account =
+        account_from_rlp(*leecher_state.get(byte_view(small_key)));
+    small_account.storage = keccak("new root");
+    leecher_state.put(byte_view(small_key), to_rlp(small_account));
+    storage_sync.move_to_block(block + 3, {small_key});
+    REQUIRE(!storage_sync.done());
+    REQUIRE(leecher_storage.num_reads == 2);
+
+    const auto request = storage_sync.next_sync_request();
+    const auto storage_request =
+        std::get_if<sync::GetStorageRequest>(&request);
+    REQUIRE(storage_request);
+    REQUIRE(storage_request->accounts == std::vector<Hash>{small_key});
+  }
+
+  SECTION("storage changed mid-sync") {
+    MemDbBucket leecher_state;
+    MemDbBucket leecher_storage;
+    Node leecher(leecher_state, hints, {}, &leecher_storage);
+
+    // the miner moves on once the leecher starts on the storage,
+    // so the roots of its state trie no longer match
+    bool changed = false;
+    sync::Stats stats;
+    for (int i = 0; i < 1000 && !leecher.sync_done(); ++i) {
+      const auto request = leecher.next_sync_request();
+      if (!changed &&
+          std::holds_alternative<sync::GetStorageRequest>(request)) {
+        miner.new_block();
+        location[31] = 7;
+        miner.set_storage(small_contract, location, "changed");
+        miner.set_storage(large_contract, location, "changed");
+        miner.seal_block();
+        changed = true;
+      }
+      if (std::holds_alternative<std::monostate>(request)) {
+        continue;
+      }
+      leecher.process_reply(request, miner.reply_to(request), stats);
+    }
+
+    REQUIRE(changed);
+    REQUIRE(leecher.sync_done());
+    REQUIRE(leecher_state.has_same_data(seeder_state));
+    REQUIRE(leecher_storage.has_same_data(seeder_storage));
+  }
+}
@@ -0,0 +1,59 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "tuner.hpp"
+
+#include <catch2/catch.hpp>
+
+#include "memdb_bucket.hpp"
+
+using namespace silkworm;
+
+TEST_CASE("Tuner", "[sync]") {
+  sync::Hints initial;
+  sync::Tuner tuner(initial);
+
+  // nothing observed yet
+  auto hints = tuner.hints();
+  REQUIRE(hints.num_leaves == initial.num_leaves);
+  REQUIRE(hints.leaf_size == initial.leaf_size);
+  REQUIRE(hints.changes_per_block == initial.changes_per_block);
+
+  sync::Stats stats;
+  stats.reply_total_leaves = 10;
+  stats.reply_total_leaf_bytes = 10 * 300;
+  tuner.observe(stats);
+  REQUIRE(tuner.hints().leaf_size == 300);
+
+  // contract-heavy state
+  MemDbBucket db;
+  for (uint8_t i = 0; i < 100; ++i) {
+    Hash key{};
+    key[0] = i;
+    db.put(byte_view(key), std::string(1000 - kHashBytes, 'x'));
+  }
+  tuner.observe(db);
+  tuner.observe_blocks(10, 25);
+
+  hints = tuner.hints();
+  REQUIRE(hints.num_leaves == 100);
+  REQUIRE(hints.leaf_size == 1000);
+  REQUIRE(hints.changes_per_block == 2);
+
+  // bigger leaves mean fewer of them fit into a reply
+  hints.num_leaves = initial.num_leaves;
+  REQUIRE(hints.optimal_phase1_depth() >= initial.optimal_phase1_depth());
+}
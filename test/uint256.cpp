@@ -0,0 +1,107 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "uint256.hpp"
+
+#include <random>
+
+#include <catch2/catch.hpp>
+
+using namespace silkworm;
+
+namespace {
+
+UInt256 random_uint256(std::mt19937_64& rng) {
+  UInt256 x;
+  const auto num_words = rng() % 5;
+  for (unsigned i = 0; i < num_words; ++i) {
+    x.set_word(i, rng());
+  }
+  return x >> rng() % 64;
+}
+
+}  // namespace
+
+TEST_CASE("UInt256", "[common]") {
+  // 2^256 - 1
+  constexpr auto kMax = UInt256{0} - 1;
+  static_assert(kMax.bit_length() == 256);
+  static_assert(kMax + 1 == 0);
+  static_assert((UInt256{1} << 255) * 2 == 0);
+  static_assert(UInt256{1} << 64 > UInt256{0xffff'ffff'ffff'ffff});
+
+#ifdef __SIZEOF_INT128__
+  SECTION("vs 128-bit built-ins") {
+    std::mt19937_64 rng(1);
+    for (int i = 0; i < 1000; ++i) {
+      const UInt128 a = (UInt128{rng()} << 64) | rng();
+      const UInt128 b = rng() >> rng() % 64;
+      const auto to_uint256 = [](UInt128 x) {
+        return (UInt256{static_cast<uint64_t>(x >> 64)} << 64) |
+               static_cast<uint64_t>(x);
+      };
+
+      const auto low128 = (UInt256{1} << 128) - 1;
+
+      const auto sum = to_uint256(a) + to_uint256(b);
+      REQUIRE((sum >> 128) == (a + b < a ? 1 : 0));
+      REQUIRE((sum & low128) == to_uint256(a + b));
+      REQUIRE(((to_uint256(a) * to_uint256(b)) & low128) == to_uint256(a * b));
+      REQUIRE(to_uint256(a) - to_uint256(b) + to_uint256(b) == to_uint256(a));
+      if (b != 0) {
+        REQUIRE(to_uint256(a) / to_uint256(b) == to_uint256(a / b));
+        REQUIRE(to_uint256(a) % to_uint256(b) == to_uint256(a % b));
+      }
+      REQUIRE((to_uint256(a) < to_uint256(b)) == (a < b));
+    }
+  }
+#endif
+
+  SECTION("divmod") {
+    std::mt19937_64 rng(2);
+    for (int i = 0; i < 1000; ++i) {
+      const auto x = random_uint256(rng);
+      const auto y = random_uint256(rng);
+      if (!y) {
+        REQUIRE_THROWS_AS(x / y, std::domain_error);
+        continue;
+      }
+      const auto [quotient, rem] = UInt256::divmod(x, y);
+      REQUIRE(rem < y);
+      REQUIRE(quotient * y + rem == x);
+    }
+
+    // by a single word or less
+    for (int i = 0; i < 1000; ++i) {
+      const auto x = random_uint256(rng);
+      const UInt256 y = (rng() >> rng() % 64) | 1;
+      const auto [quotient, rem] = UInt256::divmod(x, y);
+      REQUIRE(rem < y);
+      REQUIRE(quotient * y + rem == x);
+    }
+  }
+
+  SECTION("to_string") {
+    REQUIRE(to_string(0) == "0");
+    REQUIRE(to_string(UInt256{1} << 64) == "18446744073709551616");
+    REQUIRE(to_string(UInt256{10'000'000'000'000'000'000ull} *
+                      10'000'000'000'000'000'000ull) ==
+            "100000000000000000000000000000000000000");
+    REQUIRE(to_string(kMax) ==
+            "115792089237316195423570985008687907853269984665640564039457584007"
+            "913129639935");
+  }
+}
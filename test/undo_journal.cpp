@@ -0,0 +1,91 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "undo_journal.hpp"
+
+#include <algorithm>
+
+#include <catch2/catch.hpp>
+
+#include "memdb_bucket.hpp"
+
+using namespace silkworm;
+
+TEST_CASE("Undo journal", "[db]") {
+  MemDbBucket db;
+  db.put("a", "1");
+  db.put("b", "2");
+
+  UndoJournal journal(2);
+  REQUIRE(!journal.earliest_block());
+  CHECK_THROWS(journal.unwind(db, 10));
+
+  // changes before the first seal can't be told apart by block
+  journal.record(db, "b");
+  db.put("b", "2");
+  journal.seal(10);
+  REQUIRE(journal.earliest_block() == 10u);
+  CHECK_THROWS(journal.unwind(db, 9));
+
+  // block 11
+  journal.record(db, "a");
+  db.put("a", "3");
+  journal.record(db, "a");
+  db.put("a", "4");
+  journal.record(db, "c");
+  db.put("c", "5");
+  journal.seal(11);
+
+  // block 12
+  journal.record(db, "b");
+  db.del("b", std::string("b\0", 2));
+  journal.seal(12);
+
+  // only the last 2 blocks are kept
+  REQUIRE(journal.earliest_block() == 10u);
+  CHECK_THROWS(journal.unwind(db, 9));
+
+  // unsealed changes are undone too
+  journal.record(db, "d");
+  db.put("d", "6");
+
+  auto keys = journal.unwind(db, 11);
+  std::sort(keys.begin(), keys.end());
+  CHECK(keys == std::vector<std::string>{"b", "d"});
+  CHECK(db.get("b") == "2");
+  CHECK(!db.get("d"));
+
+  keys = journal.unwind(db, 10);
+  std::sort(keys.begin(), keys.end());
+  CHECK(keys == std::vector<std::string>{"a", "c"});
+  CHECK(db.get("a") == "1");
+  CHECK(!db.get("c"));
+  CHECK(journal.earliest_block() == 10u);
+  CHECK(db.get("b") == "2");
+
+  // a gap leaves nothing to roll back
+  journal.record(db, "a");
+  db.put("a", "7");
+  journal.seal(20);
+  CHECK(journal.earliest_block() == 20u);
+  CHECK_THROWS(journal.unwind(db, 19));
+  CHECK(journal.unwind(db, 20).empty());
+  CHECK(db.get("a") == "7");
+
+  UndoJournal genesis(2);
+  genesis.seal(0);
+  CHECK(genesis.earliest_block() == 0u);
+}
@@ -0,0 +1,212 @@
+/*
+   Copyright 2019 Ethereum Foundation
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "verifier.hpp"
+
+#include <catch2/catch.hpp>
+
+#include "memdb_bucket.hpp"
+#include "state.hpp"
+
+using namespace silkworm;
+
+TEST_CASE("Verify leaves reply", "[sync]") {
+  const auto depth = 3u;
+  const auto block = 74;
+
+  MemDbBucket seeder_db;
+  for (uint8_t i = 0; i < 40; ++i) {
+    Hash key{};
+    key[0] = 0x27;
+    key[1] = i * 6;
+    key[31] = i;
+    seeder_db.put(byte_view(key), std::string(i + 1, 'x'));
+  }
+  State seeder(seeder_db, depth, depth);
+  seeder.init_from_db(block);
+
+  for (const auto prefix : {"27"_prefix, "274"_prefix, "2"_prefix}) {
+    sync::GetLeavesRequest request{prefix};
+    auto reply = seeder.get_leaves(request);
+    REQUIRE(reply.leaves);
+    REQUIRE(reply.leaves->size() > 1);
+
+    SECTION("good " + prefix.to_string()) {
+      const auto verdict = sync::verify(request, reply, depth);
+      REQUIRE(verdict.ok());
+      REQUIRE(verdict.leaf_hashes.size() == reply.leaves->size());
+      REQUIRE(!verdict.top_empty);
+      REQUIRE(verdict.top_hash == seeder.root_hash());
+
+      MemDbBucket leecher_db;
+      State leecher(leecher_db, depth, depth);
+      REQUIRE(leecher.process_leaves_reply(prefix, reply, &verdict));
+      REQUIRE(leecher_db.get(byte_view(reply.leaves->front().first)));
+    }
+
+    SECTION("misordered " + prefix.to_string()) {
+      auto leaves = reply.leaves->to_vector();
+      std::swap(leaves.front(), leaves.back());
+      reply.leaves = sync::LeafBatch(leaves);
+      REQUIRE(!sync::verify(request, reply, depth).ok());
+    }
+
+    SECTION("duplicate " + prefix.to_string()) {
+      auto leaves = reply.leaves->to_vector();
+      leaves.push_back(leaves.back());
+      reply.leaves = sync::LeafBatch(leaves);
+      REQUIRE(!sync::verify(request, reply, depth).ok());
+    }
+
+    SECTION("outside prefix " + prefix.to_string()) {
+      auto leaves = reply.leaves->to_vector();
+      leaves.back().first[0] = 0x28;
+      reply.leaves = sync::LeafBatch(leaves);
+      REQUIRE(!sync::verify(request, reply, depth).ok());
+    }
+
+    SECTION("tampered value " + prefix.to_string()) {
+      auto leaves = reply.leaves->to_vector();
+      leaves.front().second += "y";
+      reply.leaves = sync::LeafBatch(leaves);
+      REQUIRE(!sync::verify(request, reply, depth).ok());
+    }
+
+    SECTION("tampered proof " + prefix.to_string()) {
+      reply.proof.back().hash[prefix.last()][0] ^= 1;
+      REQUIRE(!sync::verify(request, reply, depth).ok());
+    }
+
+    SECTION("missing leaf " + prefix.to_string()) {
+      auto leaves = reply.leaves->to_vector();
+      leaves.pop_back();
+      reply.leaves = sync::LeafBatch(leaves);
+      REQUIRE(!sync::verify(request, reply, depth).ok());
+    }
+
+    SECTION("proof without leaves " + prefix.to_string()) {
+      // would mark the subtree synced with none of its leaves in the db
+      reply.leaves.reset();
+      REQUIRE(!sync::verify(request, reply, depth).ok());
+    }
+  }
+}
+
+TEST_CASE("Partial proof checked against the tree", "[sync]") {
+  const auto depth = 3u;
+  const auto block = 74;
+
+  MemDbBucket seeder_db;
+  Hash key{};
+  key[0] = 0x27;
+  key[1] = 0x40;
+  seeder_db.put(byte_view(key), "crypto kitties");
+  key[0] = 0x91;
+  seeder_db.put(byte_view(key), "teh DAO");
+
+  State seeder(seeder_db, depth, depth);
+  seeder.init_from_db(block);
+
+  // the leecher has the root, so it may skip it in the proof
+  MemDbBucket leecher_db;
+  State leecher(leecher_db, depth, 1);
+  sync::GetNodeRequest node_request{{}, {""_prefix}, {}};
+  leecher.process_node_reply(node_request, *seeder.get_nodes(node_request));
+
+  sync::GetLeavesRequest request{"274"_prefix};
+  request.block_number = block;
+  request.from_level = 1;
+  const auto reply = seeder.get_leaves(request);
+  REQUIRE(reply.proof.size() == 2);
+  const auto good = sync::verify(request, reply, depth);
+  REQUIRE(good.ok());
+
+  // consistent on its own, but not with the root the leecher has
+  MemDbBucket forger_db;
+  forger_db.put(byte_view(key), "teh DAO");
+  key[0] = 0x27;
+  forger_db.put(byte_view(key), "forged");
+  State forger(forger_db, depth, depth);
+  forger.init_from_db(block);
+  const auto forged = forger.get_leaves(request);
+  const auto bad = sync::verify(request, forged, depth);
+  REQUIRE(bad.ok());
+
+  REQUIRE(!leecher.process_leaves_reply(request.prefix, forged, &bad));
+  REQUIRE(!leecher_db.get(byte_view(key)));
+
+  REQUIRE(leecher.process_leaves_reply(request.prefix, reply, &good));
+  REQUIRE(leecher_db.get(byte_view(key)) == "crypto kitties");
+}
+
+TEST_CASE("Leaves left out if the requester has them", "[sync]") {
+  const auto depth = 3u;
+
+  MemDbBucket db;
+  Hash key{};
+  key[0] = 0x27;
+  key[1] = 0x40;
+  db.put(byte_view(key), "crypto kitties");
+  State seeder(db, depth, depth);
+  seeder.init_from_db(74);
+
+  sync::GetLeavesRequest request{"274"_prefix};
+  const auto full = seeder.get_leaves(request);
+  REQUIRE(full.leaves);
+
+  request.hash = full.proof.back().hash[4];
+  const auto reply = seeder.get_leaves(request);
+  REQUIRE(!reply.leaves);
+  REQUIRE(reply.proof.size() == 3);
+  const auto verdict = sync::verify(request, reply, depth);
+  REQUIRE(verdict.ok());
+  REQUIRE(verdict.top_hash == seeder.root_hash());
+
+  request.hash->front() ^= 1;
+  REQUIRE(seeder.get_leaves(request).leaves);
+  REQUIRE(!sync::verify(request, reply, depth).ok());
+}
+
+TEST_CASE("Verifier threads", "[sync]") {
+  const auto depth = 3u;
+
+  MemDbBucket db;
+  Hash key{};
+  key[0] = 0x27;
+  db.put(byte_view(key), "crypto kitties");
+  State seeder(db, depth, depth);
+  seeder.init_from_db(74);
+
+  const sync::Request request{sync::GetLeavesRequest{"27"_prefix}};
+  const sync::Reply good = seeder.get_leaves(
+      std::get<sync::GetLeavesRequest>(request));
+  auto bad = good;
+  auto& bad_leaves = std::get<sync::LeavesReply>(bad).leaves;
+  auto leaves = bad_leaves->to_vector();
+  leaves.front().second = "forged";
+  bad_leaves = sync::LeafBatch(leaves);
+
+  for (unsigned num_threads : {0u, 3u}) {
+    sync::Verifier verifier(num_threads);
+    std::vector<std::future<sync::Verdict>> verdicts;
+    for (int i = 0; i < 10; ++i) {
+      verdicts.push_back(verifier.submit(request, i % 2 ? bad : good, depth));
+    }
+    for (int i = 0; i < 10; ++i) {
+      REQUIRE(verdicts[i].get().ok() == (i % 2 == 0));
+    }
+  }
+}